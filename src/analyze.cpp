@@ -0,0 +1,241 @@
+#include "analyze.h"
+#include "board.h"
+#include "search.h"
+#include "tt.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// File: analyze.cpp
+// Purpose: Stream positions from a file through a pool of searching workers.
+// Notes:
+//  - Input lines are FENs or EPD records. Blank lines and lines starting
+//    with '#' are skipped. EPD operations are ignored except id, which is
+//    echoed, and hmvc and fmvn, which set the move counters.
+//  - The reader hands lines to the workers through a small bounded queue,
+//    so memory stays flat however long the input is.
+//  - Each worker owns its Board, search state and transposition table, and
+//    runs single-threaded searches. Workers share nothing but the queue and
+//    the output lock. The table is not cleared between positions; entries
+//    from earlier positions age out through the search generation.
+
+// Pending lines per worker before the reader blocks
+static const size_t QUEUE_PER_WORKER = 4;
+
+struct AnalyzeJob {
+  long long line;    // 1-based line number in the input
+  std::string text;
+};
+
+// Bounded single-producer, multi-consumer queue of input lines
+class JobQueue {
+public:
+  explicit JobQueue(size_t capacity) : cap(capacity) {}
+
+  void push(AnalyzeJob job){
+    std::unique_lock<std::mutex> lock(m);
+    notFull.wait(lock, [&]{ return jobs.size() < cap; });
+    jobs.push_back(std::move(job));
+    notEmpty.notify_one();
+  }
+
+  // No more pushes. Workers drain what is left, then pop returns false.
+  void close(){
+    std::lock_guard<std::mutex> lock(m);
+    closed = true;
+    notEmpty.notify_all();
+  }
+
+  bool pop(AnalyzeJob& out){
+    std::unique_lock<std::mutex> lock(m);
+    notEmpty.wait(lock, [&]{ return closed || !jobs.empty(); });
+    if(jobs.empty()) return false;
+    out = std::move(jobs.front());
+    jobs.pop_front();
+    notFull.notify_one();
+    return true;
+  }
+
+private:
+  std::mutex m;
+  std::condition_variable notEmpty, notFull;
+  std::deque<AnalyzeJob> jobs;
+  size_t cap;
+  bool closed{false};
+};
+
+static bool isNumber(const std::string& s){
+  return !s.empty() && std::all_of(s.begin(), s.end(), [](char c){ return std::isdigit((unsigned char)c); });
+}
+
+// Split an input line into a FEN loadFEN accepts and the EPD id, if any
+static bool parseLine(const std::string& text, std::string& fen, std::string& id){
+  std::istringstream in(text);
+  std::string placement, side, castling, ep;
+  if(!(in >> placement >> side >> castling >> ep)) return false;
+  fen = placement;
+  for(const std::string* f : { &side, &castling, &ep }){ fen += ' '; fen += *f; }
+
+  std::string rest;
+  std::getline(in, rest);
+  std::istringstream counters(rest);
+  std::string half, full, extra;
+  if(counters >> half >> full && isNumber(half) && isNumber(full) && !(counters >> extra)){
+    fen += ' '; fen += half; fen += ' '; fen += full;
+    return true;
+  }
+
+  // EPD operations: "opcode operand...;" each
+  std::string halfmove("0"), fullmove("1");
+  size_t start = 0;
+  while(start < rest.size()){
+    size_t end = rest.find(';', start);
+    if(end == std::string::npos) end = rest.size();
+    std::istringstream op(rest.substr(start, end - start));
+    std::string code, operand;
+    op >> code;
+    std::getline(op >> std::ws, operand);
+    while(!operand.empty() && std::isspace((unsigned char)operand.back())) operand.pop_back();
+    if(code == "id"){
+      if(operand.size() >= 2 && operand.front() == '"' && operand.back() == '"') operand = operand.substr(1, operand.size() - 2);
+      id = operand;
+    } else if(code == "hmvc" && isNumber(operand)){
+      halfmove = operand;
+    } else if(code == "fmvn" && isNumber(operand)){
+      fullmove = operand;
+    }
+    start = end + 1;
+  }
+  fen += ' '; fen += halfmove; fen += ' '; fen += fullmove;
+  return true;
+}
+
+static void appendJsonString(std::string& out, const std::string& s){
+  out += '"';
+  for(char c : s){
+    if(c == '"' || c == '\\'){ out += '\\'; out += c; }
+    else if((unsigned char)c < 0x20){
+      char buf[8];
+      std::snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+      out += buf;
+    }
+    else out += c;
+  }
+  out += '"';
+}
+
+// One JSON line for a searched position
+static std::string resultJson(long long line, const std::string& id, const std::string& fen,
+                              const SearchResult& res, long long ms){
+  std::string out = "{\"line\":";
+  out += std::to_string(line);
+  if(!id.empty()){ out += ",\"id\":"; appendJsonString(out, id); }
+  out += ",\"fen\":";
+  appendJsonString(out, fen);
+  out += ",\"depth\":"; out += std::to_string(res.depth);
+  out += ",\"bestmove\":";
+  if(res.best.isNone()) out += "null";
+  else { out += '"'; out += moveToUci(res.best); out += '"'; }
+  if(isMateScore(res.score)){ out += ",\"mate\":"; out += std::to_string(mateInMoves(res.score)); }
+  else { out += ",\"cp\":"; out += std::to_string(res.score); }
+  out += ",\"nodes\":"; out += std::to_string(res.nodes);
+  out += ",\"time_ms\":"; out += std::to_string(ms);
+  out += ",\"pv\":[";
+  for(size_t i = 0; i < res.pv.size(); ++i){
+    if(i) out += ',';
+    out += '"'; out += moveToUci(res.pv[i]); out += '"';
+  }
+  out += ']';
+  if constexpr(SEARCH_STATS){ out += ",\"stats\":"; out += statsJson(res.stats); }
+  out += "}\n";
+  return out;
+}
+
+static std::string errorJson(long long line, const std::string& text){
+  std::string out = "{\"line\":";
+  out += std::to_string(line);
+  out += ",\"input\":";
+  appendJsonString(out, text);
+  out += ",\"error\":\"invalid position\"}\n";
+  return out;
+}
+
+bool analyze(const AnalyzeOptions& opts){
+  std::ifstream file;
+  std::istream* in = &std::cin;
+  if(opts.input != "-"){
+    file.open(opts.input);
+    if(!file){
+      std::fprintf(stderr, "cannot open %s\n", opts.input.c_str());
+      return false;
+    }
+    in = &file;
+  }
+
+  const int workers = std::clamp(opts.workers, 1, MAX_THREADS);
+  JobQueue queue(size_t(workers) * QUEUE_PER_WORKER);
+  std::mutex outputMutex;
+  std::atomic<long long> searched{0}, failed{0};
+  std::atomic<unsigned long long> totalNodes{0};
+  const auto start = std::chrono::steady_clock::now();
+
+  auto work = [&]{
+    TranspositionTable tt;
+    tt.resize(opts.hashMB);
+    SearchLimits limits;
+    limits.depth = std::clamp(opts.depth, 1, MAX_PLY);
+    limits.tt = &tt;
+
+    AnalyzeJob job;
+    while(queue.pop(job)){
+      std::string fen, id, out;
+      Board b;
+      if(!parseLine(job.text, fen, id) || !b.loadFEN(fen)){
+        out = errorJson(job.line, job.text);
+        ++failed;
+      } else {
+        const auto t0 = std::chrono::steady_clock::now();
+        const SearchResult res = search_root(b, limits);
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+        out = resultJson(job.line, id, fen, res, (long long)ms);
+        totalNodes += res.nodes;
+        ++searched;
+      }
+      std::lock_guard<std::mutex> lock(outputMutex);
+      std::fwrite(out.data(), 1, out.size(), stdout);
+      std::fflush(stdout);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for(int i = 0; i < workers; ++i) pool.emplace_back(work);
+
+  std::string text;
+  long long line = 0;
+  while(std::getline(*in, text)){
+    ++line;
+    if(!text.empty() && text.back() == '\r') text.pop_back();
+    const size_t first = text.find_first_not_of(" \t");
+    if(first == std::string::npos || text[first] == '#') continue;
+    queue.push(AnalyzeJob{line, text.substr(first)});
+  }
+  queue.close();
+  for(std::thread& t : pool) t.join();
+
+  const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  const unsigned long long nodes = totalNodes.load();
+  std::fprintf(stderr, "analyzed %lld positions (%lld invalid) with %d workers in %lld ms, %llu nodes, %llu nps\n",
+               searched.load(), failed.load(), workers, (long long)ms, nodes,
+               ms > 0 ? nodes * 1000ULL / (unsigned long long)ms : 0ULL);
+  return true;
+}
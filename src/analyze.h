@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// File: analyze.h
+// Purpose: Batch analysis of a FEN or EPD file across worker threads.
+
+constexpr int ANALYZE_DEFAULT_DEPTH = 10;
+constexpr size_t ANALYZE_DEFAULT_HASH_MB = 16;
+
+struct AnalyzeOptions {
+  std::string input{"-"};                  // position file, "-" for stdin
+  int depth{ANALYZE_DEFAULT_DEPTH};        // search depth per position
+  int workers{1};                          // positions searched at once
+  size_t hashMB{ANALYZE_DEFAULT_HASH_MB};  // transposition table size per worker
+};
+
+// Search every position in the input to depth and write one JSON object per
+// line to stdout, in completion order. Each object carries the input line
+// number so the output can be matched or sorted back to the input. A summary
+// goes to stderr. Returns false if the input cannot be opened.
+bool analyze(const AnalyzeOptions& opts);
@@ -0,0 +1,114 @@
+#include "attacks.h"
+
+// File: attacks.cpp
+// Purpose: Build the slider attack tables behind attacks.h.
+// Notes:
+//  - Magic multipliers were found offline by random search with a fixed seed.
+//    Each one maps every blocker subset of its mask to a collision-free index.
+//  - Tables are built once from slow ray walks. Lookups never walk rays.
+
+Magic ROOK_MAGICS[64];
+Magic BISHOP_MAGICS[64];
+
+static Bitboard ROOK_TABLE[102400];
+static Bitboard BISHOP_TABLE[5248];
+
+static const Bitboard ROOK_MAGIC_NUMBERS[64] = {
+  0x008000908064C000ULL,  0x0040200040001000ULL,  0x0180100080A0010AULL,  0x8880041000800800ULL,
+  0x1200100201200804ULL,  0x0200020004011008ULL,  0x2180010000800600ULL,  0x0200005088210204ULL,
+  0x0400800040008021ULL,  0x0400400020005000ULL,  0x8240801000200080ULL,  0x8611001004200900ULL,
+  0x008180800C001800ULL,  0x0100800200800400ULL,  0x0A02000102000408ULL,  0x8020802300104280ULL,
+  0x0080004000402000ULL,  0xE010104000402000ULL,  0x0800808010002000ULL,  0xA280210008100100ULL,
+  0x0001818014000800ULL,  0xA002010100080400ULL,  0x0080240001020870ULL,  0x0001020004048845ULL,
+  0x0081826280004004ULL,  0x2020810900284000ULL,  0x0200100080802000ULL,  0x0200080080100080ULL,
+  0x8083080100100500ULL,  0x4406000901000400ULL,  0x0005020080800100ULL,  0x0090204200008114ULL,
+  0x0010400094800420ULL,  0x0900804000802002ULL,  0x0201001841002000ULL,  0x4100080080801000ULL,
+  0x4540040080800800ULL,  0x0002001004040020ULL,  0x0281195814001002ULL,  0x1240800040800100ULL,
+  0x0880042000524004ULL,  0x02C080410206002CULL,  0x0801200241050010ULL,  0x8400080010008080ULL,
+  0x0008000500090010ULL,  0x0082009084020008ULL,  0x4012000108020004ULL,  0x9000104D08860004ULL,
+  0x2004204114800100ULL,  0x0148802112400300ULL,  0x0202842000100880ULL,  0x001B080080900080ULL,
+  0x001A002008100600ULL,  0x0004008004020080ULL,  0x5181000600040300ULL,  0x0000044401128A00ULL,
+  0x8044110480002441ULL,  0x2008110084402202ULL,  0x90806005090010C1ULL,  0x000420310A004A42ULL,
+  0x0023001004020801ULL,  0x0882001008040102ULL,  0x000230088118020CULL,  0x0000019025040042ULL
+};
+
+static const Bitboard BISHOP_MAGIC_NUMBERS[64] = {
+  0x0045010808008680ULL,  0x2002080204004898ULL,  0x0210009A10400006ULL,  0x0824050200810200ULL,
+  0x0006061105004090ULL,  0x00010108C0000000ULL,  0x0814040282104004ULL,  0x0012012201106800ULL,
+  0x10823014100C1040ULL,  0x0080C2088802808CULL,  0x0281108410404000ULL,  0x0101212041826200ULL,
+  0x0020141028221058ULL,  0x2201020202200202ULL,  0x000082A801482000ULL,  0x0000008401411044ULL,
+  0x0007103014300404ULL,  0x0002091110010100ULL,  0x42140012040C0808ULL,  0x0800808802004020ULL,
+  0x90C4004210140000ULL,  0x0800200900A01000ULL,  0x00D0400201108810ULL,  0x80820183814412A0ULL,
+  0x00A01008202202B4ULL,  0x01C2021A09500402ULL,  0x0084440208042400ULL,  0x800400400C090100ULL,
+  0xBA10040010802100ULL,  0xD182009006005000ULL,  0x5011021001009004ULL,  0x0020420200510400ULL,
+  0x0292104000468800ULL,  0x00043009091C0500ULL,  0x0280441000020025ULL,  0x0042820080080080ULL,
+  0x0440101010010040ULL,  0x1000900100808080ULL,  0x0108108120089800ULL,  0x0044010200012682ULL,
+  0xC002500420900400ULL,  0x0040482210710800ULL,  0x0002060024000200ULL,  0x0281020A44000800ULL,
+  0xA0021200A4000200ULL,  0x0001301000840840ULL,  0x2868500108444220ULL,  0x0004111041000200ULL,
+  0x8044020842080200ULL,  0x0000220104210200ULL,  0x0000021201044000ULL,  0x0000280884040028ULL,
+  0x4012114010858003ULL,  0x0000081004082B88ULL,  0x3892700508208002ULL,  0x00220A041B060400ULL,
+  0x0812020284014881ULL,  0x010434A282103100ULL,  0x0490400824020800ULL,  0x4A20002C00208800ULL,
+  0x000000A011020200ULL,  0x4002940A02482202ULL,  0x5100100202140406ULL,  0x02102000840540C1ULL
+};
+
+// Walk the four given directions until a blocker, blockers included
+static Bitboard slideAttacks(int sq, Bitboard occ, const int dR[4], const int dF[4]){
+  Bitboard att = 0;
+  int r0 = sq / 8, f0 = sq % 8;
+  for(int d = 0; d < 4; ++d){
+    int r = r0 + dR[d], f = f0 + dF[d];
+    while(r >= 0 && r < 8 && f >= 0 && f < 8){
+      Bitboard m = 1ULL << (r*8 + f);
+      att |= m;
+      if(occ & m) break;
+      r += dR[d]; f += dF[d];
+    }
+  }
+  return att;
+}
+
+// Relevant blocker mask: the rays without their last square at the board edge
+static Bitboard relevantMask(int sq, const int dR[4], const int dF[4]){
+  Bitboard mask = 0;
+  int r0 = sq / 8, f0 = sq % 8;
+  for(int d = 0; d < 4; ++d){
+    int r = r0 + dR[d], f = f0 + dF[d];
+    while(r + dR[d] >= 0 && r + dR[d] < 8 && f + dF[d] >= 0 && f + dF[d] < 8){
+      mask |= 1ULL << (r*8 + f);
+      r += dR[d]; f += dF[d];
+    }
+  }
+  return mask;
+}
+
+static void initSlider(Magic magics[64], Bitboard* table, const Bitboard numbers[64],
+                       const int dR[4], const int dF[4]){
+  Bitboard* next = table;
+  for(int sq = 0; sq < 64; ++sq){
+    Magic& m = magics[sq];
+    m.mask = relevantMask(sq, dR, dF);
+    m.magic = numbers[sq];
+    m.shift = unsigned(64 - popcount(m.mask));
+    m.attacks = next;
+    // Enumerate every subset of the mask (Carry-Rippler) and record its attacks
+    Bitboard sub = 0;
+    do {
+      next[m.index(sub)] = slideAttacks(sq, sub, dR, dF);
+      sub = (sub - m.mask) & m.mask;
+    } while(sub);
+    next += 1ULL << popcount(m.mask);
+  }
+}
+
+// Runs the table build during static initialization
+struct AttackTablesInit {
+  AttackTablesInit(){
+    static const int rookR[4]   = { 1,-1, 0, 0 };
+    static const int rookF[4]   = { 0, 0, 1,-1 };
+    static const int bishopR[4] = { 1, 1,-1,-1 };
+    static const int bishopF[4] = { 1,-1, 1,-1 };
+    initSlider(ROOK_MAGICS, ROOK_TABLE, ROOK_MAGIC_NUMBERS, rookR, rookF);
+    initSlider(BISHOP_MAGICS, BISHOP_TABLE, BISHOP_MAGIC_NUMBERS, bishopR, bishopF);
+  }
+};
+static const AttackTablesInit attackTablesInit;
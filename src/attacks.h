@@ -0,0 +1,115 @@
+#pragma once
+#include "bitboard.h"
+#if defined(BLITZ_USE_PEXT)
+#include <immintrin.h>
+#endif
+
+// File: attacks.h
+// Purpose: Attack lookups shared by move generation, check tests and SEE.
+// Notes:
+//  - Leaper tables (knight, king, pawn per color) and the square-to-square
+//    line tables are constexpr, built by the compiler. Nothing runs at
+//    startup and nothing needs an init check.
+//  - Slider attacks: each square owns a slice of a precomputed attack table,
+//    indexed by the blockers on its relevant rays (board edges excluded).
+//  - Default slider index is magic multiplication. Building with
+//    BLITZ_USE_PEXT (CMake option BLITZ_PEXT) uses the BMI2 _pext_u64
+//    instruction instead.
+//  - Slider tables are filled during static initialization, before main()
+//    runs. At over 100k entries they exceed the compilers' default constexpr
+//    evaluation limits.
+
+// Fixed-size tables computed at compile time
+struct LeaperTables {
+  Bitboard knight[64]{};
+  Bitboard king[64]{};
+  Bitboard pawn[2][64]{};      // squares a pawn of color c on sq attacks, c 0 white, 1 black
+  Bitboard between[64][64]{};  // squares strictly between a and b on a shared line, else 0
+  Bitboard line[64][64]{};     // the full line through a and b including both, else 0
+};
+
+// Square at rank r, file f as a bit, or 0 off the board
+constexpr Bitboard squareBit(int r, int f){
+  return (r >= 0 && r < 8 && f >= 0 && f < 8) ? 1ULL << (r * 8 + f) : 0ULL;
+}
+
+constexpr LeaperTables makeLeaperTables(){
+  LeaperTables t{};
+  const int knightR[8] = { 2, 2,-2,-2, 1, 1,-1,-1 };
+  const int knightF[8] = { 1,-1, 1,-1, 2,-2, 2,-2 };
+  const int dirR[8] = { 1, 1, 1, 0, 0,-1,-1,-1 };
+  const int dirF[8] = { 1, 0,-1, 1,-1, 1, 0,-1 };
+  for(int sq = 0; sq < 64; ++sq){
+    const int r = sq / 8, f = sq % 8;
+    for(int k = 0; k < 8; ++k){
+      t.knight[sq] |= squareBit(r + knightR[k], f + knightF[k]);
+      t.king[sq] |= squareBit(r + dirR[k], f + dirF[k]);
+    }
+    t.pawn[0][sq] = squareBit(r + 1, f - 1) | squareBit(r + 1, f + 1);
+    t.pawn[1][sq] = squareBit(r - 1, f - 1) | squareBit(r - 1, f + 1);
+
+    // Walk each direction, recording the line and the squares passed so far
+    for(int d = 0; d < 8; ++d){
+      auto ray = [&](int step){ return squareBit(r + step * dirR[d], f + step * dirF[d]); };
+      Bitboard full = 1ULL << sq;
+      for(int step = 1; ray(step); ++step) full |= ray(step);
+      for(int step = -1; ray(step); --step) full |= ray(step);
+      Bitboard between = 0;
+      for(int step = 1; ray(step); ++step){
+        const int to = lsb(ray(step));
+        t.between[sq][to] = between;
+        t.line[sq][to] = full;
+        between |= ray(step);
+      }
+    }
+  }
+  return t;
+}
+
+inline constexpr LeaperTables LEAPERS = makeLeaperTables();
+
+constexpr Bitboard knightAttacks(int sq){ return LEAPERS.knight[sq]; }
+constexpr Bitboard kingAttacks(int sq){ return LEAPERS.king[sq]; }
+// Squares a pawn of color c (0 white, 1 black) on sq attacks
+constexpr Bitboard pawnAttacks(int c, int sq){ return LEAPERS.pawn[c][sq]; }
+constexpr Bitboard squaresBetween(int a, int b){ return LEAPERS.between[a][b]; }
+constexpr Bitboard lineThrough(int a, int b){ return LEAPERS.line[a][b]; }
+
+static_assert(knightAttacks(0) == 0x0000000000020400ULL, "knight table");
+static_assert(kingAttacks(63) == 0x40C0000000000000ULL, "king table");
+static_assert(pawnAttacks(0, 8) == 0x0000000000020000ULL, "pawn table");
+static_assert(squaresBetween(0, 63) == 0x0040201008040200ULL, "between table");
+static_assert(lineThrough(9, 18) == 0x8040201008040201ULL, "line table");
+
+struct Magic {
+  Bitboard mask{0};          // relevant occupancy for this square
+  Bitboard magic{0};         // multiplier, unused with PEXT
+  const Bitboard* attacks{}; // this square's slice of the attack table
+  unsigned shift{0};         // 64 minus popcount(mask)
+
+  unsigned index(Bitboard occ) const {
+#if defined(BLITZ_USE_PEXT)
+    return unsigned(_pext_u64(occ, mask));
+#else
+    return unsigned(((occ & mask) * magic) >> shift);
+#endif
+  }
+};
+
+extern Magic ROOK_MAGICS[64];
+extern Magic BISHOP_MAGICS[64];
+
+// Squares attacked by a slider on sq, blockers included
+inline Bitboard bishopAttacks(int sq, Bitboard occ){
+  const Magic& m = BISHOP_MAGICS[sq];
+  return m.attacks[m.index(occ)];
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occ){
+  const Magic& m = ROOK_MAGICS[sq];
+  return m.attacks[m.index(occ)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occ){
+  return bishopAttacks(sq, occ) | rookAttacks(sq, occ);
+}
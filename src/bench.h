@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+
+// File: bench.h
+// Purpose: Fixed-suite search benchmark for speed and search-change checks.
+
+// The suite, also used as a position corpus by the microbenchmarks
+extern const char* const BENCH_FENS[];
+extern const int BENCH_FEN_COUNT;
+
+constexpr int BENCH_DEFAULT_DEPTH = 7;
+constexpr size_t BENCH_DEFAULT_HASH_MB = 16;
+
+// Search every suite position to depth, print per-position and total nodes,
+// time and nps. With one thread the total node count is a signature of the
+// search: it changes only when search behaviour changes. Returns the total.
+unsigned long long bench(int depth, int threads, size_t hashMB);
@@ -1,50 +1,169 @@
 #include "board.h"
 #include "bitboard.h"
+#include "attacks.h"
+#include "zobrist.h"
+#include "eval.h"
+#include <algorithm>
+#include <cassert>
 #include <cstring>
+#include <sstream>
 
 // File: board.cpp
 // Purpose: Hold board state and update it with makeMove and unmakeMove.
 // Notes:
 //  - Bitboards in pcs[] hold piece locations.
-//  - occ[WHITE], occ[BLACK], and occAll are derived. Call set_occ() after edits.
-//  - ply counts half moves made from the start of the session.
+//  - occ[WHITE], occ[BLACK], occAll, board[], material[] and pst[] are derived.
+//    makeMove and unmakeMove update them with xor deltas and running sums
+//    through putPiece/removePiece/movePiece. Call refresh() after editing
+//    pcs[] directly.
+//  - makeMove saves the previous ep square, castling rights, key, halfmove
+//    clock, moving and captured piece in the caller's State. unmakeMove reads
+//    them back, so the Board itself keeps no history. The neural eval replays
+//    the moving and captured pieces to update its accumulators.
 //  - epSquare is the en passant target square index, or -1 if none.
 //  - castleRights bits: 0 Wk, 1 Wq, 2 Bk, 3 Bq.
+//  - loadFEN accepts the six FEN fields, the last two optional. Castling
+//    rights without the king and rook on their home squares are dropped.
+//  - key is xored piece by piece in makeMove. unmakeMove restores the saved key.
+//    Debug builds assert it matches computeKey() after every move.
 
 void Board::clear(){
   std::memset(pcs, 0, sizeof(pcs));
+  std::memset(board, NO_PIECE, sizeof(board));
   occ[WHITE] = occ[BLACK] = occAll = 0ULL;
+  material[WHITE] = material[BLACK] = pst[WHITE] = pst[BLACK] = 0;
   stm = WHITE;
-  ply = 0;
   epSquare = -1;
   castleRights = 0;
+  key = 0ULL;
+  halfmoveClock = 0;
+  fullmoveNumber = 1;
+}
+
+static const char PIECE_CHARS[] = "PNBRQKpnbrqk"; // indexed by Piece
+static const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Parse a non-negative decimal FEN counter
+static bool parseCounter(const std::string& s, int& out){
+  if(s.empty() || s.size() > 6) return false;
+  int v = 0;
+  for(char c : s){
+    if(c < '0' || c > '9') return false;
+    v = v * 10 + (c - '0');
+  }
+  out = v;
+  return true;
 }
 
 bool Board::loadFEN(const std::string& fen){
-  clear();
-  if(fen == "startpos"){
-    // White pieces
-    pcs[WR] = (1ULL<<0) | (1ULL<<7);
-    pcs[WN] = (1ULL<<1) | (1ULL<<6);
-    pcs[WB] = (1ULL<<2) | (1ULL<<5);
-    pcs[WQ] = (1ULL<<3);
-    pcs[WK] = (1ULL<<4);
-    pcs[WP] = 0x000000000000FF00ULL;
-    // Black pieces
-    pcs[BR] = (1ULL<<56) | (1ULL<<63);
-    pcs[BN] = (1ULL<<57) | (1ULL<<62);
-    pcs[BB] = (1ULL<<58) | (1ULL<<61);
-    pcs[BQ] = (1ULL<<59);
-    pcs[BK] = (1ULL<<60);
-    pcs[BP] = 0x00FF000000000000ULL;
-
-    set_occ();
-    stm = WHITE;
-    epSquare = -1;
-    castleRights = 0xF; // all four rights enabled at start
-    return true;
+  std::istringstream in(fen == "startpos" ? std::string(START_FEN) : fen);
+  std::string placement, side, castling, ep, half, full, extra;
+  if(!(in >> placement >> side >> castling >> ep)) return false;
+  in >> half >> full;
+  if(in >> extra) return false;
+
+  Board nb;
+
+  // Piece placement, rank 8 first
+  int rank = 7, file = 0;
+  for(char c : placement){
+    if(c == '/'){
+      if(file != 8 || rank == 0) return false;
+      --rank;
+      file = 0;
+    } else if(c >= '1' && c <= '8'){
+      file += c - '0';
+      if(file > 8) return false;
+    } else {
+      const char* pc = std::strchr(PIECE_CHARS, c);
+      if(!pc || !*pc || file > 7) return false;
+      nb.pcs[pc - PIECE_CHARS] |= 1ULL << (rank * 8 + file);
+      ++file;
+    }
   }
-  return false;
+  if(rank != 0 || file != 8) return false;
+  if(popcount(nb.pcs[WK]) != 1 || popcount(nb.pcs[BK]) != 1) return false;
+  if((nb.pcs[WP] | nb.pcs[BP]) & 0xFF000000000000FFULL) return false; // pawns on a back rank
+
+  // Side to move
+  if(side == "w") nb.stm = WHITE;
+  else if(side == "b") nb.stm = BLACK;
+  else return false;
+
+  // Castling rights, kept only when king and rook are on their home squares
+  if(castling != "-"){
+    for(char c : castling){
+      switch(c){
+        case 'K': nb.castleRights |= 1; break;
+        case 'Q': nb.castleRights |= 2; break;
+        case 'k': nb.castleRights |= 4; break;
+        case 'q': nb.castleRights |= 8; break;
+        default: return false;
+      }
+    }
+  }
+  if(!(nb.pcs[WK] & (1ULL << 4)))  nb.castleRights &= 0xC;
+  if(!(nb.pcs[WR] & (1ULL << 7)))  nb.castleRights &= 0xE;
+  if(!(nb.pcs[WR] & (1ULL << 0)))  nb.castleRights &= 0xD;
+  if(!(nb.pcs[BK] & (1ULL << 60))) nb.castleRights &= 0x3;
+  if(!(nb.pcs[BR] & (1ULL << 63))) nb.castleRights &= 0xB;
+  if(!(nb.pcs[BR] & (1ULL << 56))) nb.castleRights &= 0x7;
+
+  // En passant target, on the rank behind a pawn that just made a double push
+  if(ep != "-"){
+    if(ep.size() != 2 || ep[0] < 'a' || ep[0] > 'h') return false;
+    const int epRank = (nb.stm == WHITE) ? 5 : 2;
+    if(ep[1] - '1' != epRank) return false;
+    const int sq = epRank * 8 + (ep[0] - 'a');
+    const int pushed = (nb.stm == WHITE) ? sq - 8 : sq + 8;
+    if(!(nb.pcs[nb.stm == WHITE ? BP : WP] & (1ULL << pushed))) return false;
+    nb.epSquare = sq;
+  }
+
+  // Move counters, optional
+  if(!half.empty() && !parseCounter(half, nb.halfmoveClock)) return false;
+  if(!full.empty() && (!parseCounter(full, nb.fullmoveNumber) || nb.fullmoveNumber == 0)) return false;
+
+  nb.refresh();
+  // The side that just moved cannot be left in check
+  if(nb.inCheck(nb.stm == WHITE ? BLACK : WHITE)) return false;
+
+  *this = nb;
+  return true;
+}
+
+std::string Board::toFEN() const{
+  std::string out;
+  for(int rank = 7; rank >= 0; --rank){
+    int empty = 0;
+    for(int file = 0; file < 8; ++file){
+      int p = board[rank * 8 + file];
+      if(p == NO_PIECE){ ++empty; continue; }
+      if(empty){ out.push_back(char('0' + empty)); empty = 0; }
+      out.push_back(PIECE_CHARS[p]);
+    }
+    if(empty) out.push_back(char('0' + empty));
+    if(rank) out.push_back('/');
+  }
+
+  out += (stm == WHITE) ? " w " : " b ";
+  if(!castleRights) out.push_back('-');
+  if(castleRights & 1) out.push_back('K');
+  if(castleRights & 2) out.push_back('Q');
+  if(castleRights & 4) out.push_back('k');
+  if(castleRights & 8) out.push_back('q');
+  out.push_back(' ');
+  if(epSquare == -1){
+    out.push_back('-');
+  } else {
+    out.push_back(char('a' + epSquare % 8));
+    out.push_back(char('1' + epSquare / 8));
+  }
+  out.push_back(' ');
+  out += std::to_string(halfmoveClock);
+  out.push_back(' ');
+  out += std::to_string(fullmoveNumber);
+  return out;
 }
 
 void Board::set_occ(){
@@ -53,257 +172,272 @@ void Board::set_occ(){
   occAll = occ[WHITE] | occ[BLACK];
 }
 
-int Board::piece_at(int sq) const{
-  Bitboard mask = 1ULL << sq;
+void Board::refresh(){
+  set_occ();
+  std::memset(board, NO_PIECE, sizeof(board));
   for(int p = WP; p <= BK; ++p){
-    if(pcs[p] & mask) return p;
+    Bitboard bb = pcs[p];
+    while(bb){ board[lsb(poplsb(bb))] = uint8_t(p); }
   }
-  return NO_PIECE;
+  computeAccumulators(material, pst);
+  key = computeKey();
 }
 
-std::string Board::toFEN() const{
-  // Not implemented yet.
-  return "startpos-stub";
+void Board::computeAccumulators(int mat[2], int sq[2]) const{
+  mat[WHITE] = mat[BLACK] = sq[WHITE] = sq[BLACK] = 0;
+  for(int p = WP; p <= BK; ++p){
+    Bitboard bb = pcs[p];
+    while(bb){
+      int s = lsb(poplsb(bb));
+      mat[p / 6] += PIECE_VALUE[p];
+      sq[p / 6] += PIECE_SQUARE[p][s];
+    }
+  }
 }
 
-void Board::makeMove(const Move m)
+bool Board::accumulatorsValid() const{
+  int mat[2], sq[2];
+  computeAccumulators(mat, sq);
+  return mat[WHITE] == material[WHITE] && mat[BLACK] == material[BLACK] &&
+         sq[WHITE] == pst[WHITE] && sq[BLACK] == pst[BLACK] &&
+         (occ[WHITE] | occ[BLACK]) == occAll;
+}
+
+uint64_t Board::computeKey() const{
+  uint64_t k = 0ULL;
+  for(int p = WP; p <= BK; ++p){
+    Bitboard bb = pcs[p];
+    while(bb){
+      Bitboard one = poplsb(bb);
+      k ^= ZOBRIST.piece[p][lsb(one)];
+    }
+  }
+  k ^= ZOBRIST.castle[castleRights & 0xF];
+  if(epSquare != -1) k ^= ZOBRIST.epFile[epSquare % 8];
+  if(stm == BLACK) k ^= ZOBRIST.side;
+  return k;
+}
+
+// Bookkeeping shared by every piece placement. Key updates are left to the
+// caller because unmakeMove restores the saved key instead.
+inline void Board::putPiece(int p, int sq){
+  const Bitboard m = 1ULL << sq;
+  const int c = p / 6;
+  pcs[p] |= m;
+  occ[c] ^= m;
+  occAll ^= m;
+  board[sq] = uint8_t(p);
+  material[c] += PIECE_VALUE[p];
+  pst[c] += PIECE_SQUARE[p][sq];
+}
+
+inline void Board::removePiece(int p, int sq){
+  const Bitboard m = 1ULL << sq;
+  const int c = p / 6;
+  pcs[p] ^= m;
+  occ[c] ^= m;
+  occAll ^= m;
+  board[sq] = NO_PIECE;
+  material[c] -= PIECE_VALUE[p];
+  pst[c] -= PIECE_SQUARE[p][sq];
+}
+
+inline void Board::movePiece(int p, int from, int to){
+  const Bitboard m = (1ULL << from) | (1ULL << to);
+  const int c = p / 6;
+  pcs[p] ^= m;
+  occ[c] ^= m;
+  occAll ^= m;
+  board[from] = NO_PIECE;
+  board[to] = uint8_t(p);
+  pst[c] += PIECE_SQUARE[p][to] - PIECE_SQUARE[p][from];
+}
+
+void Board::makeMove(const Move m, State& st)
 {
+  const int from = m.from(), to = m.to();
+  const int promo = m.isPromo() ? promoPiece(m, stm) : 0;
+
   // Save reversible state
-  hist[ply].last = m;
-  hist[ply].prevEpSquare = epSquare;
-  hist[ply].prevCastleRights = castleRights;
+  st.last = m;
+  st.moved = board[from];
+  st.prevEpSquare = epSquare;
+  st.prevCastleRights = castleRights;
+  st.prevKey = key;
+  st.prevHalfmove = halfmoveClock;
 
   // Identify moving and captured pieces
-  int movingPiece = piece_at(m.from);
-  int capturedPiece = piece_at(m.to);
+  int movingPiece = board[from];
+  int capturedPiece = board[to];
+  int capSq = to;
 
   // En passant capture sets captured piece behind the to square
-  if(m.flags & MF_ENPASSANT){
+  if(m.isEnPassant()){
     capturedPiece = (stm == WHITE) ? BP : WP;
+    capSq = (stm == WHITE) ? (to - 8) : (to + 8);
   }
-  hist[ply].captured = capturedPiece;
+  st.captured = capturedPiece;
 
   // Remove captured piece from the board
   if(capturedPiece != NO_PIECE){
-    if(m.flags & MF_ENPASSANT){
-      int capSq = (stm == WHITE) ? (m.to - 8) : (m.to + 8);
-      pcs[capturedPiece] &= ~(1ULL << capSq);
-    } else {
-      pcs[capturedPiece] &= ~(1ULL << m.to);
-    }
+    removePiece(capturedPiece, capSq);
+    key ^= ZOBRIST.piece[capturedPiece][capSq];
   }
 
   // Clear en passant, may set again on double pawn push
+  if(epSquare != -1) key ^= ZOBRIST.epFile[epSquare % 8];
   epSquare = -1;
+  key ^= ZOBRIST.castle[castleRights];
 
   // Update castling rights on king and rook moves
   if(movingPiece == WK){ castleRights &= ~(1u << 0); castleRights &= ~(1u << 1); }
   if(movingPiece == BK){ castleRights &= ~(1u << 2); castleRights &= ~(1u << 3); }
-  if(movingPiece == WR){ if(m.from == 0) castleRights &= ~(1u << 1); if(m.from == 7) castleRights &= ~(1u << 0); }
-  if(movingPiece == BR){ if(m.from == 56) castleRights &= ~(1u << 3); if(m.from == 63) castleRights &= ~(1u << 2); }
+  if(movingPiece == WR){ if(from == 0) castleRights &= ~(1u << 1); if(from == 7) castleRights &= ~(1u << 0); }
+  if(movingPiece == BR){ if(from == 56) castleRights &= ~(1u << 3); if(from == 63) castleRights &= ~(1u << 2); }
   // Update rights if a rook was captured on the original square
-  if(capturedPiece == WR){ if(m.to == 0) castleRights &= ~(1u << 1); if(m.to == 7) castleRights &= ~(1u << 0); }
-  if(capturedPiece == BR){ if(m.to == 56) castleRights &= ~(1u << 3); if(m.to == 63) castleRights &= ~(1u << 2); }
+  if(capturedPiece == WR){ if(to == 0) castleRights &= ~(1u << 1); if(to == 7) castleRights &= ~(1u << 0); }
+  if(capturedPiece == BR){ if(to == 56) castleRights &= ~(1u << 3); if(to == 63) castleRights &= ~(1u << 2); }
+
+  key ^= ZOBRIST.castle[castleRights];
 
   // Execute the move
-  if(m.promo != 0){
+  if(promo != 0){
     // Promotion replaces the pawn with the new piece
-    pcs[movingPiece] &= ~(1ULL << m.from);
-    pcs[m.promo]     |=  (1ULL << m.to);
-  } else if(m.flags & MF_CASTLE){
-    // Move king first
-    pcs[movingPiece] &= ~(1ULL << m.from);
-    pcs[movingPiece] |=  (1ULL << m.to);
-    // Move rook based on side and destination
-    if(stm == WHITE){
-      if(m.to == 6){ // e1g1
-        pcs[WR] &= ~(1ULL << 7);
-        pcs[WR] |=  (1ULL << 5);
-      } else if(m.to == 2){ // e1c1
-        pcs[WR] &= ~(1ULL << 0);
-        pcs[WR] |=  (1ULL << 3);
-      }
-    } else { // Black
-      if(m.to == 62){ // e8g8
-        pcs[BR] &= ~(1ULL << 63);
-        pcs[BR] |=  (1ULL << 61);
-      } else if(m.to == 58){ // e8c8
-        pcs[BR] &= ~(1ULL << 56);
-        pcs[BR] |=  (1ULL << 59);
-      }
-    }
+    removePiece(movingPiece, from);
+    putPiece(promo, to);
+    key ^= ZOBRIST.piece[movingPiece][from] ^ ZOBRIST.piece[promo][to];
   } else {
-    // Normal move
-    pcs[movingPiece] &= ~(1ULL << m.from);
-    pcs[movingPiece] |=  (1ULL << m.to);
+    movePiece(movingPiece, from, to);
+    key ^= ZOBRIST.piece[movingPiece][from] ^ ZOBRIST.piece[movingPiece][to];
 
-    // Set en passant target on a double pawn push
-    if(movingPiece == WP && (m.to - m.from) == 16){ epSquare = m.from + 8; }
-    if(movingPiece == BP && (m.from - m.to) == 16){ epSquare = m.from - 8; }
+    if(m.isCastle()){
+      // Move the rook based on the king's destination
+      int rookFrom, rookTo;
+      castleRookSquares(to, rookFrom, rookTo);
+      int rook = (stm == WHITE) ? WR : BR;
+      movePiece(rook, rookFrom, rookTo);
+      key ^= ZOBRIST.piece[rook][rookFrom] ^ ZOBRIST.piece[rook][rookTo];
+    } else if(m.isDoublePush()){
+      // Set en passant target behind the pushed pawn
+      epSquare = (from + to) / 2;
+      key ^= ZOBRIST.epFile[epSquare % 8];
+    }
   }
 
-  set_occ();
+  // Move counters
+  if(capturedPiece != NO_PIECE || movingPiece == WP || movingPiece == BP) halfmoveClock = 0;
+  else ++halfmoveClock;
+  if(stm == BLACK) ++fullmoveNumber;
+
   stm = (stm == WHITE) ? BLACK : WHITE;
-  ++ply;
+  key ^= ZOBRIST.side;
+  assert(key == computeKey());
+  assert(accumulatorsValid());
 }
 
-void Board::unmakeMove(const Move m)
+void Board::unmakeMove(const Move m, const State& st)
 {
-  // Step back ply and side
-  --ply;
+  // Step back side
   stm = (stm == WHITE) ? BLACK : WHITE;
 
-  // Restore EP and castling rights
-  epSquare = hist[ply].prevEpSquare;
-  castleRights = hist[ply].prevCastleRights;
+  // Restore EP, castling rights and key
+  epSquare = st.prevEpSquare;
+  castleRights = st.prevCastleRights;
+  key = st.prevKey;
+  halfmoveClock = st.prevHalfmove;
+  if(stm == BLACK) --fullmoveNumber;
 
-  // Promotion rollback
-  if(m.promo != 0){
-    pcs[m.promo] &= ~(1ULL << m.to);
-    int pawnPiece = (stm == WHITE) ? BP : WP; // mover was opposite of current stm
-    pcs[pawnPiece] |= (1ULL << m.from);
+  const int from = m.from(), to = m.to();
+  const int promo = m.isPromo() ? promoPiece(m, stm) : 0;
 
-    int cap = hist[ply].captured;
-    if(cap != NO_PIECE && cap != -1){
-      // EP cannot coincide with promotion, restore on to
-      pcs[cap] |= (1ULL << m.to);
-    }
-    set_occ();
-    return;
-  }
+  if(promo != 0){
+    // Promotion rollback
+    int pawnPiece = (stm == WHITE) ? WP : BP; // stm is the mover again after the flip above
+    removePiece(promo, to);
+    putPiece(pawnPiece, from);
+  } else {
+    // Move the piece back from to to from
+    movePiece(board[to], to, from);
 
-  // Move the piece back from to to from
-  int pieceOnTo = piece_at(m.to);
-  pcs[pieceOnTo] &= ~(1ULL << m.to);
-  pcs[pieceOnTo] |=  (1ULL << m.from);
-
-  // Rook rollback for castling
-  if(m.flags & MF_CASTLE){
-    if(stm == WHITE){ // mover was white
-      if(m.to == 6){ // e1g1
-        pcs[WR] &= ~(1ULL << 5);
-        pcs[WR] |=  (1ULL << 7);
-      } else if(m.to == 2){ // e1c1
-        pcs[WR] &= ~(1ULL << 3);
-        pcs[WR] |=  (1ULL << 0);
-      }
-    } else { // mover was black
-      if(m.to == 62){ // e8g8
-        pcs[BR] &= ~(1ULL << 61);
-        pcs[BR] |=  (1ULL << 63);
-      } else if(m.to == 58){ // e8c8
-        pcs[BR] &= ~(1ULL << 59);
-        pcs[BR] |=  (1ULL << 56);
-      }
+    // Rook rollback for castling
+    if(m.isCastle()){
+      int rookFrom, rookTo;
+      castleRookSquares(to, rookFrom, rookTo);
+      movePiece((stm == WHITE) ? WR : BR, rookTo, rookFrom);
     }
   }
 
   // Restore captured piece
-  int cap = hist[ply].captured;
+  int cap = st.captured;
   if(cap != NO_PIECE && cap != -1){
-    if(m.flags & MF_ENPASSANT){
-      int capSq = (stm == WHITE) ? (m.to - 8) : (m.to + 8); // mover was opposite
-      pcs[cap] |= (1ULL << capSq);
-    } else {
-      pcs[cap] |= (1ULL << m.to);
-    }
+    int capSq = m.isEnPassant() ? ((stm == WHITE) ? (to - 8) : (to + 8)) : to; // ep pawn sits behind to
+    putPiece(cap, capSq);
   }
 
-  set_occ();
+  assert(key == computeKey());
+  assert(accumulatorsValid());
 }
 
-bool Board::inCheck(Color c) const {
-  int kingSquare;
-  if(c == WHITE){
-    if(pcs[WK] == 0) return false; // no king found, treat as not in check
-    kingSquare = lsb(pcs[WK]);
-  } else {
-    if(pcs[BK] == 0) return false;
-    kingSquare = lsb(pcs[BK]);
-  }
-  Bitboard kingMask = 1ULL << kingSquare;
+// Pass the turn. st records it with an empty move. The halfmove clock
+// restarts so repetition scans stop here: nothing before a null move can
+// repeat a position reached after it.
+void Board::makeNullMove(State& st){
+  st.last = Move{};
+  st.moved = NO_PIECE;
+  st.captured = -1;
+  st.prevEpSquare = epSquare;
+  st.prevCastleRights = castleRights;
+  st.prevKey = key;
+  st.prevHalfmove = halfmoveClock;
 
-  // Pawn attacks on the king
-  if(c == WHITE){
-    Bitboard blackAtt = ((pcs[BP] & ~FILE_H) >> 7) | ((pcs[BP] & ~FILE_A) >> 9);
-    if(blackAtt & kingMask) return true;
-  } else {
-    Bitboard whiteAtt = ((pcs[WP] & ~FILE_A) << 7) | ((pcs[WP] & ~FILE_H) << 9);
-    if(whiteAtt & kingMask) return true;
-  }
+  if(epSquare != -1) key ^= ZOBRIST.epFile[epSquare % 8];
+  epSquare = -1;
+  halfmoveClock = 0;
+  stm = (stm == WHITE) ? BLACK : WHITE;
+  key ^= ZOBRIST.side;
+  assert(key == computeKey());
+}
 
-  // Knight attacks on the king
-  {
-    const int dRank[8] = { 2, 2,-2,-2, 1, 1,-1,-1 };
-    const int dFile[8] = { 1,-1, 1,-1, 2,-2, 2,-2 };
-    int rank = kingSquare / 8, file = kingSquare % 8;
-    for(int i = 0; i < 8; ++i){
-      int rr = rank + dRank[i], ff = file + dFile[i];
-      if(rr >= 0 && rr < 8 && ff >= 0 && ff < 8){
-        int sq = rr*8 + ff;
-        Bitboard m = 1ULL << sq;
-        if(c == WHITE){ if(pcs[BN] & m) return true; }
-        else           { if(pcs[WN] & m) return true; }
-      }
-    }
-  }
+void Board::unmakeNullMove(const State& st){
+  stm = (stm == WHITE) ? BLACK : WHITE;
+  epSquare = st.prevEpSquare;
+  key = st.prevKey;
+  halfmoveClock = st.prevHalfmove;
+}
 
-  // King adjacency
-  {
-    int rank = kingSquare / 8, file = kingSquare % 8;
-    for(int dr = -1; dr <= 1; ++dr){
-      for(int df = -1; df <= 1; ++df){
-        if(dr == 0 && df == 0) continue;
-        int rr = rank + dr, ff = file + df;
-        if(rr >= 0 && rr < 8 && ff >= 0 && ff < 8){
-          int sq = rr*8 + ff;
-          Bitboard m = 1ULL << sq;
-          if(c == WHITE){ if(pcs[BK] & m) return true; }
-          else           { if(pcs[WK] & m) return true; }
-        }
-      }
-    }
+// Scan back over earlier positions with the same side to move. s[n - i] holds
+// the key from i plies ago. Nothing before the last capture or pawn move can
+// repeat, so the scan stops at the halfmove clock, and at the oldest State.
+bool Board::isRepetition(const StateStack& s) const{
+  const int n = s.size();
+  const int limit = std::min(halfmoveClock, n);
+  for(int i = 4; i <= limit; i += 2){
+    if(s[n - i].prevKey == key) return true;
   }
+  return false;
+}
 
-  // Bishop or queen on diagonals
-  {
-    const int dRank[4] = { 1, 1,-1,-1 };
-    const int dFile[4] = { 1,-1, 1,-1 };
-    int rank = kingSquare / 8, file = kingSquare % 8;
-    for(int d = 0; d < 4; ++d){
-      int rr = rank + dRank[d], ff = file + dFile[d];
-      while(rr >= 0 && rr < 8 && ff >= 0 && ff < 8){
-        int sq = rr*8 + ff;
-        Bitboard m = 1ULL << sq;
-        if(occAll & m){
-          if(c == WHITE){ if((pcs[BB] | pcs[BQ]) & m) return true; }
-          else           { if((pcs[WB] | pcs[WQ]) & m) return true; }
-          break; // blocked
-        }
-        rr += dRank[d]; ff += dFile[d];
-      }
-    }
-  }
+void StateStack::assignTail(const StateStack& from, int n){
+  count = std::clamp(n, 0, from.count);
+  std::copy(from.entries + from.count - count, from.entries + from.count, entries);
+}
 
-  // Rook or queen on ranks and files
-  {
-    const int dRank[4] = { 1,-1, 0, 0 };
-    const int dFile[4] = { 0, 0, 1,-1 };
-    int rank = kingSquare / 8, file = kingSquare % 8;
-    for(int d = 0; d < 4; ++d){
-      int rr = rank + dRank[d], ff = file + dFile[d];
-      while(rr >= 0 && rr < 8 && ff >= 0 && ff < 8){
-        int sq = rr*8 + ff;
-        Bitboard m = 1ULL << sq;
-        if(occAll & m){
-          if(c == WHITE){ if((pcs[BR] | pcs[BQ]) & m) return true; }
-          else           { if((pcs[WR] | pcs[WQ]) & m) return true; }
-          break; // blocked
-        }
-        rr += dRank[d]; ff += dFile[d];
-      }
-    }
-  }
+// Check test for side C, piece indices fixed at compile time
+template<Color C>
+static bool kingAttacked(const Board& b){
+  const Bitboard king = b.pcs[C == WHITE ? WK : BK];
+  if(king == 0) return false; // no king found, treat as not in check
+  const int ksq = lsb(king);
+  constexpr int o = (C == WHITE) ? 6 : 0; // enemy piece offset
 
-  return false;
+  // An enemy pawn attacks the king if our pawn on the king square would attack it
+  return (pawnAttacks(C, ksq) & b.pcs[WP + o])
+      || (knightAttacks(ksq) & b.pcs[WN + o])
+      || (kingAttacks(ksq) & b.pcs[WK + o])
+      || (bishopAttacks(ksq, b.occAll) & (b.pcs[WB + o] | b.pcs[WQ + o]))
+      || (rookAttacks(ksq, b.occAll) & (b.pcs[WR + o] | b.pcs[WQ + o]));
+}
+
+bool Board::inCheck(Color c) const {
+  return c == WHITE ? kingAttacked<WHITE>(*this) : kingAttacked<BLACK>(*this);
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
+#include <cassert>
 #include <string>
+#include <type_traits>
 #include "bitboard.h"
 #include "move.h"
 
@@ -8,12 +10,20 @@
 // Notes:
 //  - Bitboards in pcs[] hold piece positions for each type.
 //  - occ[WHITE], occ[BLACK], and occAll track occupancy.
-//  - State hist[] stores reversible info for unmakeMove.
-//  - ply counts half-moves from the root.
+//  - board[] is a mailbox copy of pcs[], one Piece per square.
+//  - material[] and pst[] are running per-side sums used by eval().
+//  - Board is the position only, small and trivially copyable, so copy-make
+//    and per-thread copies are cheap. Undo information lives outside it: each
+//    makeMove fills a caller-owned State that unmakeMove takes back.
+//  - StateStack holds the States of a game or a search line in order. Its
+//    saved keys are what repetition detection scans.
+//  - key is the Zobrist hash, updated incrementally by makeMove.
 
 // Side to move
 enum Color { WHITE = 0, BLACK = 1 };
 
+constexpr Color operator~(Color c){ return Color(c ^ 1); } // the other side
+
 // Piece indices into pcs[]
 enum Piece {
   WP, WN, WB, WR, WQ, WK,
@@ -21,14 +31,20 @@ enum Piece {
   NO_PIECE
 };
 
-// Move flag bits
-enum MoveFlags : uint8_t {
-  MF_NONE      = 0,
-  MF_CAPTURE   = 1 << 0,
-  MF_ENPASSANT = 1 << 1,
-  MF_CASTLE    = 1 << 2,
-  MF_DOUBLE    = 1 << 3
-};
+// Piece a promotion move creates for side c
+inline int promoPiece(Move m, Color c){
+  return WN + m.promoType() + (c == WHITE ? 0 : 6);
+}
+
+// Rook squares for a castling move, from the king's destination
+inline void castleRookSquares(int kingTo, int& rookFrom, int& rookTo){
+  switch(kingTo){
+    case 6:  rookFrom = 7;  rookTo = 5;  break; // e1g1
+    case 2:  rookFrom = 0;  rookTo = 3;  break; // e1c1
+    case 62: rookFrom = 63; rookTo = 61; break; // e8g8
+    default: rookFrom = 56; rookTo = 59; break; // e8c8
+  }
+}
 
 // Reversible state stored per ply
 struct State {
@@ -36,26 +52,79 @@ struct State {
   int captured{-1};         // piece captured, or -1 if none
   int prevEpSquare{-1};     // en passant target before move, -1 if none
   uint8_t prevCastleRights{0}; // castling rights before move
+  uint8_t moved{NO_PIECE};  // piece that moved, as it was before a promotion. NO_PIECE for a null move
+  uint64_t prevKey{0};      // Zobrist key before move
+  int prevHalfmove{0};      // halfmove clock before move
+};
+
+// Most plies a StateStack can hold: a long game plus a full search line
+constexpr int MAX_HISTORY = 1024;
+
+// Undo records of the moves made since some earlier position, oldest first.
+// Each game, search thread and perft worker owns one.
+class StateStack {
+public:
+  State& push(){ assert(count < MAX_HISTORY); return entries[count++]; }
+  void pop(){ assert(count > 0); --count; }
+  const State& top() const { return entries[count - 1]; }
+  const State& operator[](int i) const { return entries[i]; }
+  int size() const { return count; }
+  bool full() const { return count == MAX_HISTORY; }
+  void clear(){ count = 0; }
+  // Replace the contents with the last n States of from, or all if fewer
+  void assignTail(const StateStack& from, int n);
+
+private:
+  State entries[MAX_HISTORY];
+  int count{0};
 };
 
-// Board holds all game state
+// Position state
 class Board {
 public:
+  Board(){ clear(); }
+
   Bitboard pcs[12]{};   // piece bitboards, indexed by Piece
   Bitboard occ[2]{};    // occupancy for each side
   Bitboard occAll{};    // all occupied squares
+  uint8_t board[64];    // Piece on each square, or NO_PIECE
+  int material[2]{};    // material per side, kings excluded
+  int pst[2]{};         // piece-square sum per side, from that side's view
   int epSquare{-1};     // en passant target square, -1 if none
   uint8_t castleRights{0}; // bit0: WK, bit1: WQ, bit2: BK, bit3: BQ
   Color stm{WHITE};     // side to move
-  State hist[512]{};    // move history for undo
-  int ply{0};           // half-move count from root
+  uint64_t key{0};      // Zobrist key of the current position
+  int halfmoveClock{0}; // half moves since the last capture or pawn move
+  int fullmoveNumber{1}; // starts at 1, incremented after Black moves
 
   void clear();
-  bool loadFEN(const std::string& fen); // only supports "startpos" for now
-  std::string toFEN() const;
-  int piece_at(int sq) const;           // return Piece enum or NO_PIECE
+  bool loadFEN(const std::string& fen); // FEN or "startpos". On error returns false, board unchanged
+  std::string toFEN() const;            // six-field FEN of the current position
+  int piece_at(int sq) const { return board[sq]; } // return Piece enum or NO_PIECE
   void set_occ();
-  void makeMove(const Move m);          // apply move, supports captures, promo, ep, castle
-  void unmakeMove(const Move m);        // undo move, restores captures/promo/ep/castle
+  void refresh();                       // rebuild occupancy, board[] and key from pcs[]
+  void makeMove(const Move m, State& st);       // apply move, saving what undo needs in st
+  void unmakeMove(const Move m, const State& st); // undo move with the st its makeMove filled
+  void makeNullMove(State& st);                 // pass the turn, for null-move pruning
+  void unmakeNullMove(const State& st);         // undo makeNullMove
+  void makeMove(const Move m, StateStack& s){ makeMove(m, s.push()); }
+  void unmakeMove(const Move m, StateStack& s){ unmakeMove(m, s.top()); s.pop(); }
+  void makeNullMove(StateStack& s){ makeNullMove(s.push()); }
+  void unmakeNullMove(StateStack& s){ unmakeNullMove(s.top()); s.pop(); }
   bool inCheck(Color c) const;          // true if side c's king is attacked
-};
\ No newline at end of file
+  // Current position occurred before since the last irreversible move, with
+  // s holding the moves that led to it
+  bool isRepetition(const StateStack& s) const;
+  bool isDraw(const StateStack& s) const { return halfmoveClock >= 100 || isRepetition(s); } // fifty-move rule or repetition
+  uint64_t computeKey() const;          // Zobrist key of the position, hashed from scratch
+  void computeAccumulators(int mat[2], int sq[2]) const; // material and pst summed from scratch
+  bool accumulatorsValid() const;       // debug check of derived fields against pcs[]
+
+private:
+  void putPiece(int p, int sq);
+  void removePiece(int p, int sq);
+  void movePiece(int p, int from, int to);
+};
+
+static_assert(std::is_trivially_copyable_v<Board>, "Board must copy as plain bytes");
+static_assert(sizeof(Board) <= 256, "Board should stay within four cache lines");
@@ -1,3 +1,14 @@
 #pragma once
 #include "board.h"
-int eval(const Board& b);
\ No newline at end of file
+
+// Material value of each Piece, kings count 0
+extern const int PIECE_VALUE[12];
+
+// Piece-square bonus of each Piece on each square, from the owner's view
+struct PieceSquareTable {
+  int v[12][64];
+  const int* operator[](int p) const { return v[p]; }
+};
+extern const PieceSquareTable PIECE_SQUARE;
+
+int eval(const Board& b);
@@ -1,8 +1,90 @@
 #pragma once
 #include <cstdint>
+#include <string>
+
+// File: move.h
+// Purpose: Packed move encoding, scored move wrapper and the fixed-capacity
+// list moves are generated into.
+// Notes:
+//  - A Move is 16 bits: from in bits 0-5, to in bits 6-11, kind in bits 12-15.
+//  - Kind bit 2 marks captures, bit 3 marks promotions. For promotions the
+//    low two bits give the piece: 0 knight, 1 bishop, 2 rook, 3 queen.
+//  - Move{} is the empty move. Moves compare as one integer.
+//  - Move has no default member initializers so a MoveList can be declared
+//    without touching all 256 slots.
+
+// Move kinds stored in the top four bits
+enum MoveKind : uint8_t {
+  MK_QUIET        = 0,
+  MK_DOUBLE       = 1,  // double pawn push
+  MK_KING_CASTLE  = 2,
+  MK_QUEEN_CASTLE = 3,
+  MK_CAPTURE      = 4,
+  MK_ENPASSANT    = 5,
+  MK_PROMO        = 8,  // add promotion piece 0..3, plus MK_CAPTURE if capturing
+};
+
+// Promotion piece, in the low two kind bits
+enum PromoType : uint8_t { PROMO_KNIGHT = 0, PROMO_BISHOP = 1, PROMO_ROOK = 2, PROMO_QUEEN = 3 };
+
 struct Move {
-  uint16_t from{0};
-  uint16_t to{0};
-  uint8_t promo{0};
-  uint8_t flags{0};
-};
\ No newline at end of file
+  uint16_t data;
+
+  Move() = default;
+  constexpr Move(int from, int to, int kind = MK_QUIET)
+    : data(uint16_t(from | (to << 6) | (kind << 12))) {}
+
+  constexpr int from() const { return data & 63; }
+  constexpr int to() const { return (data >> 6) & 63; }
+  constexpr int kind() const { return data >> 12; }
+  constexpr bool isNone() const { return data == 0; }
+  constexpr bool isCapture() const { return (data >> 12) & MK_CAPTURE; }
+  constexpr bool isPromo() const { return (data >> 12) & MK_PROMO; }
+  constexpr bool isEnPassant() const { return kind() == MK_ENPASSANT; }
+  constexpr bool isCastle() const { return kind() == MK_KING_CASTLE || kind() == MK_QUEEN_CASTLE; }
+  constexpr bool isDoublePush() const { return kind() == MK_DOUBLE; }
+  constexpr int promoType() const { return (data >> 12) & 3; } // valid only if isPromo()
+
+  constexpr bool operator==(const Move& o) const = default;
+};
+
+static_assert(sizeof(Move) == 2, "Move must pack into 16 bits");
+
+// UCI form of a move, e.g. "e2e4" or "e7e8q"
+inline std::string moveToUci(const Move& m){
+  std::string s;
+  s += char('a' + m.from() % 8);
+  s += char('1' + m.from() / 8);
+  s += char('a' + m.to() % 8);
+  s += char('1' + m.to() / 8);
+  if(m.isPromo()) s += "nbrq"[m.promoType()];
+  return s;
+}
+
+// Move plus an ordering score, kept to 32 bits
+struct ScoredMove {
+  Move move;
+  int16_t score;
+};
+
+static_assert(sizeof(ScoredMove) == 4, "ScoredMove must pack into 32 bits");
+
+// Upper bound on legal moves in any reachable position is 218
+constexpr int MAX_MOVES = 256;
+
+// Stack-resident move list. Never allocates.
+struct MoveList {
+  Move moves[MAX_MOVES];
+  int count{0};
+
+  void push_back(const Move& m){ moves[count++] = m; }
+  void clear(){ count = 0; }
+  int size() const { return count; }
+  bool empty() const { return count == 0; }
+  Move& operator[](int i){ return moves[i]; }
+  const Move& operator[](int i) const { return moves[i]; }
+  Move* begin(){ return moves; }
+  Move* end(){ return moves + count; }
+  const Move* begin() const { return moves; }
+  const Move* end() const { return moves + count; }
+};
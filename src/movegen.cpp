@@ -1,485 +1,521 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
 #include <vector>
 #include "movegen.h"
 #include "bitboard.h"
+#include "attacks.h"
+#include "perfthash.h"
 
 // File: movegen.cpp
-// Purpose: Generate pseudo-legal moves, then filter to legal by king safety.
+// Purpose: Generate legal moves using check and pin masks.
 // Also provides perft utilities.
 
-// Precomputed attack masks for knights and kings
-static Bitboard knightAttacks[64];
-static Bitboard kingAttacks[64];
-
-static inline bool onBoard(int sq){ return sq >= 0 && sq < 64; }
-
-static void initKnight(){
-  for(int sq = 0; sq < 64; ++sq){
-    int r = sq / 8, f = sq % 8;
-    Bitboard mask = 0;
-    const int dR[8] = { 2, 2,-2,-2, 1, 1,-1,-1 };
-    const int dF[8] = { 1,-1, 1,-1, 2,-2, 2,-2 };
-    for(int k = 0; k < 8; ++k){
-      int rr = r + dR[k], ff = f + dF[k];
-      if(rr >= 0 && rr < 8 && ff >= 0 && ff < 8){
-        mask |= 1ULL << (rr*8 + ff);
-      }
-    }
-    knightAttacks[sq] = mask;
-  }
+// Promotion pieces in the order they are emitted
+static const int PROMO_ORDER[4] = { PROMO_QUEEN, PROMO_ROOK, PROMO_BISHOP, PROMO_KNIGHT };
+
+static constexpr Bitboard PROMO_RANKS = 0xFF000000000000FFULL;
+
+// Board directions for side C, resolved at compile time
+template<Color C> constexpr int PAWN_UP   = C == WHITE ? 8 : -8;
+template<Color C> constexpr int PAWN_WEST = C == WHITE ? 7 : -9;  // capture toward the a-file
+template<Color C> constexpr int PAWN_EAST = C == WHITE ? 9 : -7;  // capture toward the h-file
+template<Color C> constexpr int PIECE_OFFSET = C == WHITE ? 0 : 6; // C's pieces start here in pcs[]
+
+// Pawn attack sets for all pawns in p, toward the a-file and toward the h-file
+template<Color C>
+static inline Bitboard pawnAttacksWest(Bitboard p){ return shiftBy<PAWN_WEST<C>>(p & ~FILE_A); }
+template<Color C>
+static inline Bitboard pawnAttacksEast(Bitboard p){ return shiftBy<PAWN_EAST<C>>(p & ~FILE_H); }
+
+// All pieces of either color that attack sq, given occupancy occ
+static inline Bitboard attackersTo(const Board& b, int sq, Bitboard occ){
+  // A pawn of color c attacks sq if a pawn of the other color on sq would attack it
+  const Bitboard pawns = (pawnAttacks(BLACK, sq) & b.pcs[WP]) | (pawnAttacks(WHITE, sq) & b.pcs[BP]);
+  return pawns
+       | (knightAttacks(sq) & (b.pcs[WN] | b.pcs[BN]))
+       | (kingAttacks(sq)   & (b.pcs[WK] | b.pcs[BK]))
+       | (bishopAttacks(sq, occ) & (b.pcs[WB] | b.pcs[BB] | b.pcs[WQ] | b.pcs[BQ]))
+       | (rookAttacks(sq, occ)   & (b.pcs[WR] | b.pcs[BR] | b.pcs[WQ] | b.pcs[BQ]));
 }
 
-static void initKing(){
-  for(int sq = 0; sq < 64; ++sq){
-    int r = sq / 8, f = sq % 8;
-    Bitboard mask = 0;
-    for(int dr = -1; dr <= 1; ++dr){
-      for(int df = -1; df <= 1; ++df){
-        if(dr == 0 && df == 0) continue;
-        int rr = r + dr, ff = f + df;
-        if(rr >= 0 && rr < 8 && ff >= 0 && ff < 8){
-          mask |= 1ULL << (rr*8 + ff);
-        }
-      }
-    }
-    kingAttacks[sq] = mask;
-  }
-}
-
-static bool initDone = false;
-static void ensureInit(){ if(!initDone){ initKnight(); initKing(); initDone = true; } }
-
-// True if square sq is attacked by the given side
-static inline bool attackedBy(const Board& b, int sq, Color by){
-  const Bitboard target = 1ULL << sq;
-
-  // Pawn attacks
-  if(by == WHITE){
-    Bitboard att = ((b.pcs[WP] & ~FILE_A) << 7) | ((b.pcs[WP] & ~FILE_H) << 9);
-    if(att & target) return true;
-  } else {
-    Bitboard att = ((b.pcs[BP] & ~FILE_H) >> 7) | ((b.pcs[BP] & ~FILE_A) >> 9);
-    if(att & target) return true;
-  }
-
-  // Knight attacks
-  if(by == WHITE){ if(knightAttacks[sq] & b.pcs[WN]) return true; }
-  else            { if(knightAttacks[sq] & b.pcs[BN]) return true; }
-
-  // King adjacency
-  if(by == WHITE){ if(kingAttacks[sq] & b.pcs[WK]) return true; }
-  else            { if(kingAttacks[sq] & b.pcs[BK]) return true; }
-
-  // Sliding attacks: bishops and queens on diagonals
-  {
-    const int dR[4] = { 1, 1,-1,-1 };
-    const int dF[4] = { 1,-1, 1,-1 };
-    int r0 = sq / 8, f0 = sq % 8;
-    for(int d = 0; d < 4; ++d){
-      int r = r0 + dR[d], f = f0 + dF[d];
-      while(r >= 0 && r < 8 && f >= 0 && f < 8){
-        int s = r*8 + f;
-        Bitboard m = 1ULL << s;
-        if(b.occAll & m){
-          if(by == WHITE){ if((b.pcs[WB] | b.pcs[WQ]) & m) return true; }
-          else            { if((b.pcs[BB] | b.pcs[BQ]) & m) return true; }
-          break;
-        }
-        r += dR[d]; f += dF[d];
-      }
-    }
-  }
-
-  // Sliding attacks: rooks and queens on ranks and files
-  {
-    const int dR[4] = { 1,-1, 0, 0 };
-    const int dF[4] = { 0, 0, 1,-1 };
-    int r0 = sq / 8, f0 = sq % 8;
-    for(int d = 0; d < 4; ++d){
-      int r = r0 + dR[d], f = f0 + dF[d];
-      while(r >= 0 && r < 8 && f >= 0 && f < 8){
-        int s = r*8 + f;
-        Bitboard m = 1ULL << s;
-        if(b.occAll & m){
-          if(by == WHITE){ if((b.pcs[WR] | b.pcs[WQ]) & m) return true; }
-          else            { if((b.pcs[BR] | b.pcs[BQ]) & m) return true; }
-          break;
-        }
-        r += dR[d]; f += dF[d];
-      }
-    }
-  }
-
-  return false;
+// Every square attacked by side By, given occupancy occ
+template<Color By>
+static Bitboard attacksBySide(const Board& b, Bitboard occ){
+  constexpr int o = PIECE_OFFSET<By>;
+  Bitboard att = pawnAttacksWest<By>(b.pcs[WP + o]) | pawnAttacksEast<By>(b.pcs[WP + o]);
+  Bitboard pc = b.pcs[WN + o];
+  while(pc){ att |= knightAttacks(lsb(poplsb(pc))); }
+  pc = b.pcs[WB + o] | b.pcs[WQ + o];
+  while(pc){ att |= bishopAttacks(lsb(poplsb(pc)), occ); }
+  pc = b.pcs[WR + o] | b.pcs[WQ + o];
+  while(pc){ att |= rookAttacks(lsb(poplsb(pc)), occ); }
+  if(b.pcs[WK + o]) att |= kingAttacks(lsb(b.pcs[WK + o]));
+  return att;
 }
 
 // Push all moves encoded by mask from a given origin square
-static inline void pushMovesFromMask(std::vector<Move>& out, int from, Bitboard mask){
+static inline void pushMovesFromMask(MoveList& out, int from, Bitboard mask, Bitboard enemy){
   Bitboard m = mask;
   while(m){
     Bitboard tobb = poplsb(m);
     int to = lsb(tobb);
-    out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
+    out.push_back(Move(from, to, (tobb & enemy) ? MK_CAPTURE : MK_QUIET));
   }
 }
 
-// Slide along one direction until a blocker is hit
-static inline void slideInDirection(const Board& b, std::vector<Move>& out, int from, int dr, int df){
-  int r = from / 8, f = from % 8;
-  int rr = r + dr, ff = f + df;
-  while(rr >= 0 && rr < 8 && ff >= 0 && ff < 8){
-    int to = rr*8 + ff;
-    Bitboard toMask = 1ULL << to;
-    if(b.occAll & toMask){
-      if(b.stm == WHITE){
-        if(b.occ[BLACK] & toMask) out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
-      } else {
-        if(b.occ[WHITE] & toMask) out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
-      }
-      break; // stop at first blocker
+// Push pawn moves whose destinations are in targets and whose origin is to - delta.
+// Pinned pawns must stay on the line through their king. Back rank arrivals promote.
+static inline void pushPawnMoves(MoveList& out, Bitboard targets, int delta, int kind,
+                                 Bitboard pinned, int ksq){
+  while(targets){
+    Bitboard tobb = poplsb(targets);
+    int to = lsb(tobb);
+    int from = to - delta;
+    if((pinned & (1ULL << from)) && !(lineThrough(ksq, from) & tobb)) continue;
+    if(tobb & PROMO_RANKS){
+      for(int p : PROMO_ORDER) out.push_back(Move(from, to, MK_PROMO | (kind & MK_CAPTURE) | p));
     } else {
-      out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
+      out.push_back(Move(from, to, kind));
     }
-    rr += dr; ff += df;
   }
 }
 
-// Generate pseudo-legal moves for all pieces. Adds en passant and castling. Then filter to legal.
-void generateMoves(const Board& b, std::vector<Move>& out){
-  ensureInit();
+// Move sink for counting only. Takes the same calls as a MoveList so one
+// generator body serves both, but masks are popcounted instead of expanded.
+struct MoveCounter {
+  int count{0};
+  void push_back(const Move&){ ++count; }
+  void clear(){ count = 0; }
+};
+
+static inline void pushMovesFromMask(MoveCounter& out, int, Bitboard mask, Bitboard){
+  out.count += popcount(mask);
+}
+
+// Count form of pushPawnMoves. Only pinned pawns need a per-move test.
+static inline void pushPawnMoves(MoveCounter& out, Bitboard targets, int delta, int,
+                                 Bitboard pinned, int ksq){
+  const Bitboard pinnedDest = (delta > 0) ? (pinned << delta) : (pinned >> -delta);
+  const Bitboard free = targets & ~pinnedDest;
+  out.count += popcount(free & ~PROMO_RANKS) + 4 * popcount(free & PROMO_RANKS);
+  Bitboard rest = targets & pinnedDest;
+  while(rest){
+    Bitboard tobb = poplsb(rest);
+    if(lineThrough(ksq, lsb(tobb) - delta) & tobb) out.count += (tobb & PROMO_RANKS) ? 4 : 1;
+  }
+}
+
+// Generate legal moves for side Us, which must be the side to move. Checkers,
+// pinned pieces and the evasion mask are computed once, so no move has to be
+// played to test it, except en passant.
+// GEN_CAPTURES keeps captures, en passant and promotions, GEN_QUIETS the rest.
+// Out is a MoveList, or a MoveCounter to only count.
+template<Color Us, typename Out>
+static void generateInto(const Board& b, Out& out, GenType type){
   out.clear();
-  const Bitboard empty = ~b.occAll;
-
-  if(b.stm == WHITE){
-    // Pawn single pushes
-    Bitboard singles = (b.pcs[WP] << 8) & empty;
-    Bitboard tmp = singles;
-    while(tmp){
-      Bitboard tobb = poplsb(tmp);
-      int to = lsb(tobb);
-      int from = to - 8;
-      out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
-    }
-    // Pawn double pushes from rank 2
-    Bitboard doubles = ((singles & (RANK_2 << 8)) << 8) & empty;
-    tmp = doubles;
-    while(tmp){
-      Bitboard tobb = poplsb(tmp);
-      int to = lsb(tobb);
-      int from = to - 16;
-      out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
+
+  constexpr Color Them = ~Us;
+  constexpr int o = PIECE_OFFSET<Us>;    // our piece offset into pcs[]
+  constexpr int e = PIECE_OFFSET<Them>;  // their piece offset
+  const Bitboard own = b.occ[Us];
+  const Bitboard enemy = b.occ[Them];
+  const Bitboard occ = b.occAll;
+  const Bitboard kingBB = b.pcs[WK + o];
+  if(!kingBB) return;
+  const int ksq = lsb(kingBB);
+
+  // King moves. Danger squares are computed without our king so it cannot
+  // step back along a checking ray.
+  // Destinations allowed by the generation type
+  const Bitboard genMask = (type == GEN_CAPTURES) ? enemy : (type == GEN_QUIETS) ? ~occ : ~0ULL;
+  const Bitboard danger = attacksBySide<Them>(b, occ ^ kingBB);
+  pushMovesFromMask(out, ksq, kingAttacks(ksq) & ~own & genMask & ~danger, enemy);
+
+  const Bitboard checkers = attackersTo(b, ksq, occ) & enemy;
+  if(popcount(checkers) > 1) return; // double check, only king moves
+
+  // Destinations for all other pieces: anywhere but our own pieces, or when in
+  // check, capture the checker or block between it and the king
+  Bitboard target = ~own;
+  if(checkers) target = checkers | squaresBetween(ksq, lsb(checkers));
+  const Bitboard pieceTarget = target & genMask;
+
+  // Pinned pieces: our single blocker between the king and an enemy slider
+  Bitboard pinned = 0;
+  {
+    Bitboard snipers = (rookAttacks(ksq, enemy)   & (b.pcs[WR + e] | b.pcs[WQ + e]))
+                     | (bishopAttacks(ksq, enemy) & (b.pcs[WB + e] | b.pcs[WQ + e]));
+    while(snipers){
+      int s = lsb(poplsb(snipers));
+      Bitboard blockers = squaresBetween(ksq, s) & occ;
+      if(popcount(blockers) == 1 && (blockers & own)) pinned |= blockers;
     }
-    // Pawn captures
-    Bitboard capNW = ((b.pcs[WP] & ~FILE_A) << 7) & b.occ[BLACK];
-    Bitboard capNE = ((b.pcs[WP] & ~FILE_H) << 9) & b.occ[BLACK];
-    tmp = capNW;
-    while(tmp){
-      Bitboard tobb = poplsb(tmp);
-      int to = lsb(tobb);
-      int from = to - 7;
-      out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
+  }
+
+  // Pawns
+  {
+    constexpr int up = PAWN_UP<Us>;
+    constexpr Bitboard startRank = Us == WHITE ? RANK_2 : RANK_7;
+    const Bitboard pawns = b.pcs[WP + o];
+    const Bitboard empty = ~occ;
+
+    Bitboard singles = shiftBy<up>(pawns) & empty;
+    Bitboard doubles = shiftBy<up>(singles & shiftBy<up>(startRank)) & empty;
+    // Promotion pushes count as captures for generation purposes
+    if(type != GEN_QUIETS) pushPawnMoves(out, singles & target & PROMO_RANKS, up, MK_QUIET, pinned, ksq);
+    if(type != GEN_CAPTURES){
+      pushPawnMoves(out, singles & target & ~PROMO_RANKS, up, MK_QUIET, pinned, ksq);
+      pushPawnMoves(out, doubles & target, 2 * up, MK_DOUBLE, pinned, ksq);
     }
-    tmp = capNE;
-    while(tmp){
-      Bitboard tobb = poplsb(tmp);
-      int to = lsb(tobb);
-      int from = to - 9;
-      out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
+    if(type != GEN_QUIETS){
+      pushPawnMoves(out, pawnAttacksWest<Us>(pawns) & enemy & target, PAWN_WEST<Us>, MK_CAPTURE, pinned, ksq);
+      pushPawnMoves(out, pawnAttacksEast<Us>(pawns) & enemy & target, PAWN_EAST<Us>, MK_CAPTURE, pinned, ksq);
     }
 
-    // En passant
-    if(b.epSquare != -1){
+    // En passant. Verified by replaying the occupancy change, which also
+    // catches the rank pin where both pawns leave the king's rank.
+    if(b.epSquare != -1 && type != GEN_QUIETS){
       const int epsq = b.epSquare;
       const Bitboard epMask = 1ULL << epsq;
-      if((b.pcs[WP] & ~FILE_A) & (epMask >> 7)){
-        const int from = epsq - 7;
-        out.push_back(Move{(uint16_t)from,(uint16_t)epsq,0,(uint8_t)(MF_ENPASSANT | MF_CAPTURE)});
-      }
-      if((b.pcs[WP] & ~FILE_H) & (epMask >> 9)){
-        const int from = epsq - 9;
-        out.push_back(Move{(uint16_t)from,(uint16_t)epsq,0,(uint8_t)(MF_ENPASSANT | MF_CAPTURE)});
+      const int capSq = epsq - up;
+      Bitboard from = pawnAttacks(Them, epsq) & pawns;
+      while(from){
+        Bitboard frombb = poplsb(from);
+        Bitboard after = (occ ^ frombb ^ (1ULL << capSq)) | epMask;
+        Bitboard attackers = attackersTo(b, ksq, after) & enemy & ~(1ULL << capSq);
+        if(!attackers){
+          out.push_back(Move(lsb(frombb), epsq, MK_ENPASSANT));
+        }
       }
     }
+  }
 
-    // Knights
-    {
-      Bitboard kn = b.pcs[WN];
-      while(kn){
-        Bitboard frombb = poplsb(kn);
-        int from = lsb(frombb);
-        Bitboard attacks = knightAttacks[from];
-        Bitboard quiets = attacks & ~b.occAll;
-        Bitboard caps   = attacks & b.occ[BLACK];
-        pushMovesFromMask(out, from, quiets);
-        pushMovesFromMask(out, from, caps);
-      }
+  // Knights. A pinned knight can never move.
+  {
+    Bitboard kn = b.pcs[WN + o] & ~pinned;
+    while(kn){
+      int from = lsb(poplsb(kn));
+      pushMovesFromMask(out, from, knightAttacks(from) & pieceTarget, enemy);
     }
+  }
 
-    // Bishops
-    {
-      Bitboard bb = b.pcs[WB];
-      while(bb){
-        Bitboard frombb = poplsb(bb);
-        int from = lsb(frombb);
-        slideInDirection(b, out, from,  1,  1);
-        slideInDirection(b, out, from,  1, -1);
-        slideInDirection(b, out, from, -1,  1);
-        slideInDirection(b, out, from, -1, -1);
-      }
+  // Bishops, rooks and queens. Pinned sliders stay on their pin line.
+  {
+    Bitboard diag = b.pcs[WB + o] | b.pcs[WQ + o];
+    while(diag){
+      int from = lsb(poplsb(diag));
+      Bitboard dest = bishopAttacks(from, occ) & pieceTarget;
+      if(pinned & (1ULL << from)) dest &= lineThrough(ksq, from);
+      pushMovesFromMask(out, from, dest, enemy);
     }
-
-    // Rooks
-    {
-      Bitboard rb = b.pcs[WR];
-      while(rb){
-        Bitboard frombb = poplsb(rb);
-        int from = lsb(frombb);
-        slideInDirection(b, out, from,  1,  0);
-        slideInDirection(b, out, from, -1,  0);
-        slideInDirection(b, out, from,  0,  1);
-        slideInDirection(b, out, from,  0, -1);
-      }
+    Bitboard orth = b.pcs[WR + o] | b.pcs[WQ + o];
+    while(orth){
+      int from = lsb(poplsb(orth));
+      Bitboard dest = rookAttacks(from, occ) & pieceTarget;
+      if(pinned & (1ULL << from)) dest &= lineThrough(ksq, from);
+      pushMovesFromMask(out, from, dest, enemy);
     }
+  }
 
-    // Queens
-    {
-      Bitboard qb = b.pcs[WQ];
-      while(qb){
-        Bitboard frombb = poplsb(qb);
-        int from = lsb(frombb);
-        slideInDirection(b, out, from,  1,  1);
-        slideInDirection(b, out, from,  1, -1);
-        slideInDirection(b, out, from, -1,  1);
-        slideInDirection(b, out, from, -1, -1);
-        slideInDirection(b, out, from,  1,  0);
-        slideInDirection(b, out, from, -1,  0);
-        slideInDirection(b, out, from,  0,  1);
-        slideInDirection(b, out, from,  0, -1);
-      }
+  // Castling. Not out of check, path empty, king path not attacked. Squares
+  // are given for White and moved to the eighth rank for Black.
+  constexpr int base = Us == WHITE ? 0 : 56;
+  constexpr unsigned kingSide = Us == WHITE ? 1u << 0 : 1u << 2;
+  constexpr unsigned queenSide = Us == WHITE ? 1u << 1 : 1u << 3;
+  if(!checkers && type != GEN_CAPTURES && ksq == base + 4){
+    // King side: f and g empty and not attacked, rook on h
+    constexpr Bitboard kPath = 0x60ULL << base;
+    if((b.castleRights & kingSide) && !(occ & kPath) && (b.pcs[WR + o] & (1ULL << (base + 7))) &&
+       !(danger & kPath)){
+      out.push_back(Move(base + 4, base + 6, MK_KING_CASTLE));
     }
-
-    // King
-    {
-      int from = lsb(b.pcs[WK]);
-      Bitboard attacks = kingAttacks[from];
-      Bitboard quiets = attacks & ~b.occAll;
-      Bitboard caps   = attacks & b.occ[BLACK];
-      pushMovesFromMask(out, from, quiets);
-      pushMovesFromMask(out, from, caps);
+    // Queen side: b, c and d empty, c and d not attacked, rook on a
+    constexpr Bitboard qEmpty = 0x0EULL << base;
+    constexpr Bitboard qSafe = 0x0CULL << base;
+    if((b.castleRights & queenSide) && !(occ & qEmpty) && (b.pcs[WR + o] & (1ULL << base)) &&
+       !(danger & qSafe)){
+      out.push_back(Move(base + 4, base + 2, MK_QUEEN_CASTLE));
     }
+  }
+}
 
-    // Castling
-    {
-      if(b.pcs[WK] & (1ULL << 4)){
-        // King side. Rights bit0. Squares f1 and g1 empty. Rook on h1. Path not attacked.
-        if((b.castleRights & (1u << 0)) && ((b.occAll & ((1ULL<<5)|(1ULL<<6))) == 0) && (b.pcs[WR] & (1ULL<<7))){
-          if(!attackedBy(b, 4, BLACK) && !attackedBy(b, 5, BLACK) && !attackedBy(b, 6, BLACK)){
-            out.push_back(Move{4,6,0,(uint8_t)MF_CASTLE});
-          }
-        }
-        // Queen side. Rights bit1. Squares d1 and c1 empty. Rook on a1. Path not attacked.
-        if((b.castleRights & (1u << 1)) && ((b.occAll & ((1ULL<<3)|(1ULL<<2))) == 0) && (b.pcs[WR] & (1ULL<<0))){
-          if(!attackedBy(b, 4, BLACK) && !attackedBy(b, 3, BLACK) && !attackedBy(b, 2, BLACK)){
-            out.push_back(Move{4,2,0,(uint8_t)MF_CASTLE});
-          }
-        }
-      }
-    }
+// Dispatch on the side to move to the generator built for it
+template<typename Out>
+static inline void generateInto(const Board& b, Out& out, GenType type){
+  if(b.stm == WHITE) generateInto<WHITE>(b, out, type);
+  else generateInto<BLACK>(b, out, type);
+}
 
-  } else {
-    // Black to move
-    // Pawn single pushes
-    Bitboard singles = (b.pcs[BP] >> 8) & empty;
-    Bitboard tmp = singles;
-    while(tmp){
-      Bitboard tobb = poplsb(tmp);
-      int to = lsb(tobb);
-      int from = to + 8;
-      out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
-    }
-    // Pawn double pushes from rank 7
-    Bitboard doubles = ((singles & (RANK_7 >> 8)) >> 8) & empty;
-    tmp = doubles;
-    while(tmp){
-      Bitboard tobb = poplsb(tmp);
-      int to = lsb(tobb);
-      int from = to + 16;
-      out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
-    }
-    // Pawn captures
-    Bitboard capSE = ((b.pcs[BP] & ~FILE_H) >> 7) & b.occ[WHITE];
-    Bitboard capSW = ((b.pcs[BP] & ~FILE_A) >> 9) & b.occ[WHITE];
-    tmp = capSE;
-    while(tmp){
-      Bitboard tobb = poplsb(tmp);
-      int to = lsb(tobb);
-      int from = to + 7;
-      out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
-    }
-    tmp = capSW;
-    while(tmp){
-      Bitboard tobb = poplsb(tmp);
-      int to = lsb(tobb);
-      int from = to + 9;
-      out.push_back(Move{(uint16_t)from,(uint16_t)to,0,0});
-    }
+void generateMoves(const Board& b, MoveList& out, GenType type){
+  generateInto(b, out, type);
+}
 
-    // En passant
-    if(b.epSquare != -1){
-      const int epsq = b.epSquare;
-      const Bitboard epMask = 1ULL << epsq;
-      if((b.pcs[BP] & ~FILE_H) & (epMask << 7)){
-        const int from = epsq + 7;
-        out.push_back(Move{(uint16_t)from,(uint16_t)epsq,0,(uint8_t)(MF_ENPASSANT | MF_CAPTURE)});
-      }
-      if((b.pcs[BP] & ~FILE_A) & (epMask << 9)){
-        const int from = epsq + 9;
-        out.push_back(Move{(uint16_t)from,(uint16_t)epsq,0,(uint8_t)(MF_ENPASSANT | MF_CAPTURE)});
-      }
-    }
+int countMoves(const Board& b){
+  MoveCounter counter;
+  generateInto(b, counter, GEN_ALL);
+  return counter.count;
+}
 
-    // Knights
-    {
-      Bitboard kn = b.pcs[BN];
-      while(kn){
-        Bitboard frombb = poplsb(kn);
-        int from = lsb(frombb);
-        Bitboard attacks = knightAttacks[from];
-        Bitboard quiets = attacks & ~b.occAll;
-        Bitboard caps   = attacks & b.occ[WHITE];
-        pushMovesFromMask(out, from, quiets);
-        pushMovesFromMask(out, from, caps);
-      }
-    }
+// Legality test for a move that did not come from the generator, such as a
+// TT or killer move. Plain moves, captures and double pawn pushes are checked
+// directly: the piece must reach the square and no enemy may attack our king
+// afterwards. Castling, en passant and promotions fall back to a full
+// generation.
+template<Color Us>
+static bool isLegalFor(const Board& b, Move m){
+  const int from = m.from(), to = m.to();
+  const int pc = b.board[from];
+  if(pc == NO_PIECE || (pc < 6 ? WHITE : BLACK) != Us) return false;
+
+  if(m.kind() != MK_QUIET && m.kind() != MK_CAPTURE && m.kind() != MK_DOUBLE){
+    MoveList all;
+    generateInto<Us>(b, all, GEN_ALL);
+    return std::find(all.begin(), all.end(), m) != all.end();
+  }
 
-    // Bishops
-    {
-      Bitboard bb = b.pcs[BB];
-      while(bb){
-        Bitboard frombb = poplsb(bb);
-        int from = lsb(frombb);
-        slideInDirection(b, out, from,  1,  1);
-        slideInDirection(b, out, from,  1, -1);
-        slideInDirection(b, out, from, -1,  1);
-        slideInDirection(b, out, from, -1, -1);
-      }
-    }
+  constexpr Color Them = ~Us;
+  const Bitboard fromBB = 1ULL << from, toBB = 1ULL << to;
+  const Bitboard occ = b.occAll;
+  if(m.isCapture()){
+    if(!(toBB & b.occ[Them]) || (toBB & (b.pcs[WK] | b.pcs[BK]))) return false;
+  } else if(toBB & occ){
+    return false;
+  }
 
-    // Rooks
-    {
-      Bitboard rb = b.pcs[BR];
-      while(rb){
-        Bitboard frombb = poplsb(rb);
-        int from = lsb(frombb);
-        slideInDirection(b, out, from,  1,  0);
-        slideInDirection(b, out, from, -1,  0);
-        slideInDirection(b, out, from,  0,  1);
-        slideInDirection(b, out, from,  0, -1);
+  // Can the piece reach 'to'
+  const int type = pc % 6;
+  if(m.isDoublePush() && type != WP) return false;
+  Bitboard reach = 0;
+  switch(type){
+    case WP:
+      if(toBB & PROMO_RANKS) return false; // must be a promotion kind
+      if(m.isDoublePush()){
+        constexpr Bitboard startRank = Us == WHITE ? RANK_2 : RANK_7;
+        const Bitboard mid = shiftBy<PAWN_UP<Us>>(fromBB);
+        if(!(fromBB & startRank) || (mid & occ)) return false;
+        reach = shiftBy<PAWN_UP<Us>>(mid);
+      } else {
+        reach = m.isCapture() ? pawnAttacks(Us, from) : shiftBy<PAWN_UP<Us>>(fromBB);
       }
-    }
+      break;
+    case WN: reach = knightAttacks(from); break;
+    case WB: reach = bishopAttacks(from, occ); break;
+    case WR: reach = rookAttacks(from, occ); break;
+    case WQ: reach = queenAttacks(from, occ); break;
+    default: reach = kingAttacks(from); break;
+  }
+  if(!(reach & toBB)) return false;
 
-    // Queens
-    {
-      Bitboard qb = b.pcs[BQ];
-      while(qb){
-        Bitboard frombb = poplsb(qb);
-        int from = lsb(frombb);
-        slideInDirection(b, out, from,  1,  1);
-        slideInDirection(b, out, from,  1, -1);
-        slideInDirection(b, out, from, -1,  1);
-        slideInDirection(b, out, from, -1, -1);
-        slideInDirection(b, out, from,  1,  0);
-        slideInDirection(b, out, from, -1,  0);
-        slideInDirection(b, out, from,  0,  1);
-        slideInDirection(b, out, from,  0, -1);
-      }
-    }
+  // Our king must not be attacked after the move. A captured piece on 'to'
+  // no longer attacks anything.
+  const Bitboard after = (occ ^ fromBB) | toBB;
+  const int ksq = (type == WK) ? to : lsb(b.pcs[WK + PIECE_OFFSET<Us>]);
+  return !(attackersTo(b, ksq, after) & b.occ[Them] & ~toBB);
+}
 
-    // King
-    {
-      int from = lsb(b.pcs[BK]);
-      Bitboard attacks = kingAttacks[from];
-      Bitboard quiets = attacks & ~b.occAll;
-      Bitboard caps   = attacks & b.occ[WHITE];
-      pushMovesFromMask(out, from, quiets);
-      pushMovesFromMask(out, from, caps);
-    }
+bool isLegal(const Board& b, Move m){
+  if(m.isNone()) return false;
+  return b.stm == WHITE ? isLegalFor<WHITE>(b, m) : isLegalFor<BLACK>(b, m);
+}
 
-    // Castling
-    {
-      if(b.pcs[BK] & (1ULL << 60)){
-        // King side
-        if((b.castleRights & (1u << 2)) && ((b.occAll & ((1ULL<<61)|(1ULL<<62))) == 0) && (b.pcs[BR] & (1ULL<<63))){
-          if(!attackedBy(b, 60, WHITE) && !attackedBy(b, 61, WHITE) && !attackedBy(b, 62, WHITE)){
-            out.push_back(Move{60,62,0,(uint8_t)MF_CASTLE});
-          }
-        }
-        // Queen side
-        if((b.castleRights & (1u << 3)) && ((b.occAll & ((1ULL<<59)|(1ULL<<58))) == 0) && (b.pcs[BR] & (1ULL<<56))){
-          if(!attackedBy(b, 60, WHITE) && !attackedBy(b, 59, WHITE) && !attackedBy(b, 58, WHITE)){
-            out.push_back(Move{60,58,0,(uint8_t)MF_CASTLE});
-          }
-        }
-      }
-    }
+// Static exchange values. The king is priced so no exchange ends with it captured.
+static const int SEE_VALUE[6] = { 100, 320, 330, 500, 900, 20000 };
+
+// Static exchange evaluation: material the mover expects from move m after
+// both sides keep recapturing on its destination with their cheapest piece.
+// X-ray attackers behind each capturer are added as the occupancy changes.
+int see(const Board& b, Move m){
+  if(m.isCastle()) return 0;
+  const int from = m.from(), to = m.to();
+  int gain[32];
+  int d = 0;
+
+  Bitboard occ = b.occAll ^ (1ULL << from);
+  int attackerValue = SEE_VALUE[b.board[from] % 6];
+  if(m.isEnPassant()){
+    gain[0] = SEE_VALUE[WP];
+    occ ^= 1ULL << (b.stm == WHITE ? to - 8 : to + 8);
+  } else {
+    gain[0] = (b.board[to] == NO_PIECE) ? 0 : SEE_VALUE[b.board[to] % 6];
+  }
+  if(m.isPromo()){
+    int promoValue = SEE_VALUE[WN + m.promoType()];
+    gain[0] += promoValue - SEE_VALUE[WP];
+    attackerValue = promoValue;
   }
 
-  // Legality filter. Keep only moves that do not leave our king in check.
-  {
-    std::vector<Move> legal;
-    legal.reserve(out.size());
-    Color side = b.stm;
-    for(const auto& m : out){
-      Board test = b;
-      test.makeMove(m);
-      if(!test.inCheck(side)) legal.push_back(m);
+  const Bitboard diagSliders = b.pcs[WB] | b.pcs[BB] | b.pcs[WQ] | b.pcs[BQ];
+  const Bitboard orthSliders = b.pcs[WR] | b.pcs[BR] | b.pcs[WQ] | b.pcs[BQ];
+  Bitboard attackers = attackersTo(b, to, occ) & occ;
+  Color side = (b.stm == WHITE) ? BLACK : WHITE;
+
+  while(d < 31){
+    Bitboard mine = attackers & b.occ[side];
+    if(!mine) break;
+
+    // Least valuable attacker of this side
+    const int o = (side == WHITE) ? 0 : 6;
+    int type = 0;
+    Bitboard fromSet = 0;
+    for(; type < 6; ++type){
+      fromSet = mine & b.pcs[o + type];
+      if(fromSet) break;
     }
-    out.swap(legal);
+
+    ++d;
+    gain[d] = attackerValue - gain[d - 1]; // if the sequence stopped here
+
+    occ ^= fromSet & (0ULL - fromSet); // remove the lowest such attacker
+    attackerValue = SEE_VALUE[type];
+    if(type == 0 || type == 2 || type == 4) attackers |= bishopAttacks(to, occ) & diagSliders;
+    if(type == 3 || type == 4) attackers |= rookAttacks(to, occ) & orthSliders;
+    attackers &= occ;
+    side = (side == WHITE) ? BLACK : WHITE;
+  }
+
+  while(d > 0){
+    gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+    --d;
   }
+  return gain[0];
 }
 
-unsigned long long perft(Board& b, int depth){
+// Vector form for callers outside the search, fills from a MoveList
+void generateMoves(const Board& b, std::vector<Move>& out){
+  MoveList ml;
+  generateMoves(b, ml);
+  out.assign(ml.begin(), ml.end());
+}
+
+// Per-worker perft state: the optional count cache and its local hit counters,
+// flushed to the cache once the worker is done
+struct PerftWorker {
+  PerftHash* cache{nullptr};
+  unsigned long long probes{0};
+  unsigned long long hits{0};
+
+  void flush(){ if(cache) cache->addStats(probes, hits); }
+};
+
+// Single-threaded perft below a given board, by copy-make. The last ply is
+// bulk counted without playing the moves. Subtrees of depth 2 and more go
+// through the cache when there is one.
+static unsigned long long perftNodes(const Board& b, int depth, PerftWorker& w){
   if(depth == 0) return 1ULL;
-  std::vector<Move> mv;
-  generateMoves(b, mv);
+  if(depth == 1) return (unsigned long long)countMoves(b);
+  const bool cached = w.cache && depth >= 2;
   unsigned long long nodes = 0ULL;
+  if(cached){
+    ++w.probes;
+    if(w.cache->probe(b.key, depth, nodes)){ ++w.hits; return nodes; }
+  }
+  MoveList mv;
+  generateMoves(b, mv);
+  State st;
   for(const auto& m : mv){
-    b.makeMove(m);
-    nodes += perft(b, depth - 1);
-    b.unmakeMove(m);
+    Board child = b;
+    child.makeMove(m, st);
+    nodes += perftNodes(child, depth - 1, w);
   }
+  if(cached) w.cache->store(b.key, depth, nodes);
   return nodes;
 }
 
-// Convert square index to algebraic like "a1"
-static inline const char* sqToStr(int sq){
-  static char buf[3];
-  buf[0] = char('a' + (sq % 8));
-  buf[1] = char('1' + (sq / 8));
-  buf[2] = 0;
-  return buf;
+// One unit of parallel perft: a root move, and a reply when splitting two plies
+struct PerftTask {
+  int root;     // index into the root move list
+  Move reply;   // empty when the task is the whole root move
+  unsigned long long nodes;
+};
+
+// Count nodes below every root move into counts[], using up to 'threads'
+// workers. Work is split at ply 2 when depth allows, so one heavy root move
+// does not serialize the run. Workers claim tasks through an atomic index and
+// play each one on a fresh copy of the root Board. Counts are summed per root
+// move in generation order, so the result never depends on scheduling.
+static void perftRootCounts(const Board& b, int depth, int threads, PerftHash* cache,
+                            const MoveList& roots, unsigned long long counts[]){
+  for(int i = 0; i < roots.size(); ++i) counts[i] = 0;
+  if(depth <= 0) return;
+
+  std::vector<PerftTask> tasks;
+  State st;
+  for(int i = 0; i < roots.size(); ++i){
+    if(depth < 3){ tasks.push_back(PerftTask{i, Move{}, 0}); continue; }
+    Board child = b;
+    child.makeMove(roots[i], st);
+    MoveList replies;
+    generateMoves(child, replies);
+    for(const Move& r : replies) tasks.push_back(PerftTask{i, r, 0});
+  }
+
+  std::atomic<size_t> nextTask{0};
+  auto worker = [&](){
+    PerftWorker w{cache};
+    for(size_t t = nextTask.fetch_add(1); t < tasks.size(); t = nextTask.fetch_add(1)){
+      PerftTask& task = tasks[t];
+      Board local = b; // copy-make, nothing to undo
+      State undo[2];
+      local.makeMove(roots[task.root], undo[0]);
+      if(task.reply.isNone()){
+        task.nodes = perftNodes(local, depth - 1, w);
+      } else {
+        local.makeMove(task.reply, undo[1]);
+        task.nodes = perftNodes(local, depth - 2, w);
+      }
+    }
+    w.flush();
+  };
+
+  const int n = std::clamp(threads, 1, (int)std::max<size_t>(tasks.size(), 1));
+  std::vector<std::thread> pool;
+  for(int i = 1; i < n; ++i) pool.emplace_back(worker);
+  worker();
+  for(std::thread& t : pool) t.join();
+
+  for(const PerftTask& task : tasks) counts[task.root] += task.nodes;
+}
+
+unsigned long long perft(Board& b, int depth, int threads, PerftHash* cache){
+  if(threads <= 1 || depth < 2){
+    PerftWorker w{cache};
+    unsigned long long nodes = perftNodes(b, depth, w);
+    w.flush();
+    return nodes;
+  }
+  MoveList mv;
+  generateMoves(b, mv);
+  unsigned long long counts[MAX_MOVES];
+  perftRootCounts(b, depth, threads, cache, mv, counts);
+  unsigned long long nodes = 0ULL;
+  for(int i = 0; i < mv.size(); ++i) nodes += counts[i];
+  return nodes;
 }
 
-// Print perft breakdown per root move
-void perftDivide(Board& b, int depth){
-  std::vector<Move> mv;
+// Print perft breakdown per root move, in generation order
+void perftDivide(Board& b, int depth, int threads, PerftHash* cache){
+  MoveList mv;
   generateMoves(b, mv);
-  unsigned long long total = 0ULL;
-  for(const auto& m : mv){
-    b.makeMove(m);
-    unsigned long long nodes = perft(b, depth - 1);
-    b.unmakeMove(m);
-    total += nodes;
-
-    if(m.promo){
-      char promoChar = 'q';
-      if(m.promo == WQ || m.promo == BQ) promoChar = 'q';
-      else if(m.promo == WR || m.promo == BR) promoChar = 'r';
-      else if(m.promo == WB || m.promo == BB) promoChar = 'b';
-      else if(m.promo == WN || m.promo == BN) promoChar = 'n';
-      printf("%s%s%c: %llu\n", sqToStr(m.from), sqToStr(m.to), promoChar, nodes);
-    } else {
-      printf("%s%s: %llu\n", sqToStr(m.from), sqToStr(m.to), nodes);
+  unsigned long long counts[MAX_MOVES];
+  if(threads > 1){
+    perftRootCounts(b, depth, threads, cache, mv, counts);
+  } else {
+    PerftWorker w{cache};
+    State st;
+    for(int i = 0; i < mv.size(); ++i){
+      b.makeMove(mv[i], st);
+      counts[i] = depth > 0 ? perftNodes(b, depth - 1, w) : 0;
+      b.unmakeMove(mv[i], st);
     }
+    w.flush();
+  }
+
+  unsigned long long total = 0ULL;
+  for(int i = 0; i < mv.size(); ++i){
+    printf("%s: %llu\n", moveToUci(mv[i]).c_str(), counts[i]);
+    total += counts[i];
   }
   printf("Total: %llu\n", total);
 }
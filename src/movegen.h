@@ -3,15 +3,38 @@
 #include "board.h"
 #include "move.h"
 
+class PerftHash;
+
 // File: movegen.h
 // Purpose: Generate legal or pseudo-legal moves and provide perft utilities.
 
-// Generate all pseudo-legal moves for the given position into 'out'.
-// Caller must later filter for legality if needed.
+// Which legal moves to generate
+enum GenType {
+  GEN_ALL,      // every legal move
+  GEN_CAPTURES, // captures, en passant and promotions, for quiescence search
+  GEN_QUIETS    // everything GEN_CAPTURES leaves out, castling included
+};
+
+// Generate all legal moves for the given position into 'out'.
+// The MoveList form is allocation free and meant for the search and perft.
+void generateMoves(const Board& b, MoveList& out, GenType type = GEN_ALL);
 void generateMoves(const Board& b, std::vector<Move>& out);
 
+// Number of legal moves in b, without building the list. For bulk counting.
+int countMoves(const Board& b);
+
+// True if m is legal in b. For moves from outside the generator, e.g. the TT.
+bool isLegal(const Board& b, Move m);
+
+// Static exchange evaluation of m on its destination square, in centipawns for
+// the side making it. Negative means the exchange loses material.
+int see(const Board& b, Move m);
+
 // Perft: count leaf nodes by playing all moves to given depth.
-unsigned long long perft(Board& b, int depth);
+// threads > 1 splits the first two plies across that many workers. With a
+// cache, repeated subtrees are counted once.
+unsigned long long perft(Board& b, int depth, int threads = 1, PerftHash* cache = nullptr);
 
-// Perft divide: print breakdown of nodes per root move.
-void perftDivide(Board& b, int depth);
\ No newline at end of file
+// Perft divide: print breakdown of nodes per root move. The order is the
+// generation order whatever the thread count.
+void perftDivide(Board& b, int depth, int threads = 1, PerftHash* cache = nullptr);
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include <utility>
+#include "movepick.h"
+
+// File: movepick.cpp
+// Purpose: Staged move picker implementation.
+// Notes:
+//  - Captures score by MVV-LVA, promotions add the promoted piece value.
+//  - A capture is only tested with SEE when it is picked, so losing
+//    captures found before a cutoff are the only ones that cost a SEE.
+
+// Value used for MVV scoring
+static inline int pieceValueForMVV(int p){
+  switch(p){
+    case WP: case BP: return 100;
+    case WN: case BN: return 320;
+    case WB: case BB: return 330;
+    case WR: case BR: return 500;
+    case WQ: case BQ: return 900;
+    default: return 0;
+  }
+}
+
+// Most Valuable Victim, Least Valuable Attacker score, plus the promotion gain
+static inline int captureScore(const Board& b, Move m){
+  int score = 0;
+  if(m.isCapture()){
+    int victim = m.isEnPassant() ? WP : b.piece_at(m.to());
+    score = pieceValueForMVV(victim) * 10 - pieceValueForMVV(b.piece_at(m.from()));
+  }
+  if(m.isPromo()) score += pieceValueForMVV(WN + m.promoType());
+  return score;
+}
+
+MovePicker::MovePicker(const Board& board, Move tt, const Move* killers, const HistoryTable* hist)
+  : b(board), history(hist), ttMove(tt), stage(STAGE_TT), deferBad(true){
+  if(killers){ killer[0] = killers[0]; killer[1] = killers[1]; }
+}
+
+MovePicker::MovePicker(const Board& board, bool inCheck)
+  : b(board), history(nullptr), stage(STAGE_GEN_CAPTURES), quiescence(!inCheck){}
+
+bool MovePicker::isSpecial(Move m) const{
+  return m == ttMove || m == killer[0] || m == killer[1];
+}
+
+void MovePicker::scoreCaptures(){
+  MoveList list;
+  generateMoves(b, list, GEN_CAPTURES);
+  end = 0;
+  for(const Move& m : list){
+    if(m == ttMove) continue;
+    moves[end++] = ScoredMove{m, int16_t(captureScore(b, m))};
+  }
+  cur = 0;
+}
+
+void MovePicker::scoreQuiets(){
+  MoveList list;
+  generateMoves(b, list, GEN_QUIETS);
+  end = 0;
+  for(const Move& m : list){
+    if(isSpecial(m)) continue;
+    int16_t s = history ? (*history)[m.from()][m.to()] : int16_t(0);
+    moves[end++] = ScoredMove{m, s};
+  }
+  cur = 0;
+}
+
+Move MovePicker::pickBest(){
+  int best = cur;
+  for(int i = cur + 1; i < end; ++i)
+    if(moves[i].score > moves[best].score) best = i;
+  std::swap(moves[cur], moves[best]);
+  return moves[cur++].move;
+}
+
+Move MovePicker::next(){
+  for(;;){
+    switch(stage){
+      case STAGE_TT:
+        stage = STAGE_GEN_CAPTURES;
+        if(isLegal(b, ttMove)) return ttMove;
+        break;
+
+      case STAGE_GEN_CAPTURES:
+        scoreCaptures();
+        stage = STAGE_CAPTURES;
+        break;
+
+      case STAGE_CAPTURES:
+        while(cur < end){
+          Move m = pickBest();
+          // Losing captures wait until after the quiets, or are dropped in
+          // quiescence. Evasions in quiescence keep their order.
+          if((deferBad || quiescence) && !m.isPromo() && see(b, m) < 0){
+            if(deferBad) bad[badCount++] = m;
+            continue;
+          }
+          return m;
+        }
+        stage = quiescence ? STAGE_DONE : STAGE_KILLER_1;
+        break;
+
+      case STAGE_KILLER_1:
+        stage = STAGE_KILLER_2;
+        if(!(killer[0] == ttMove) && isLegal(b, killer[0])) return killer[0];
+        break;
+
+      case STAGE_KILLER_2:
+        stage = STAGE_GEN_QUIETS;
+        if(!(killer[1] == ttMove) && !(killer[1] == killer[0]) && isLegal(b, killer[1])) return killer[1];
+        break;
+
+      case STAGE_GEN_QUIETS:
+        scoreQuiets();
+        stage = STAGE_QUIETS;
+        break;
+
+      case STAGE_QUIETS:
+        if(cur < end) return pickBest();
+        stage = STAGE_BAD_CAPTURES;
+        break;
+
+      case STAGE_BAD_CAPTURES:
+        if(badCur < badCount) return bad[badCur++];
+        stage = STAGE_DONE;
+        break;
+
+      case STAGE_DONE:
+        return Move{};
+    }
+  }
+}
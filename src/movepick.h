@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include "board.h"
+#include "movegen.h"
+
+// File: movepick.h
+// Purpose: Staged move picker for the search.
+// Notes:
+//  - Moves come out in stages: TT move, winning captures, killers, quiet
+//    moves by history, then losing captures. Each stage is generated only
+//    when the previous one is used up, so a cutoff on the TT move or a
+//    capture never pays for quiet generation.
+//  - Every move returned is legal. TT and killer moves are checked with
+//    isLegal() and not returned again by later stages.
+//  - Scores are computed once per move and the best remaining move is picked
+//    by selection, which is cheap when only the first few moves are tried.
+
+// Quiet move history, indexed [from][to] for the side to move
+using HistoryTable = int16_t[64][64];
+
+class MovePicker {
+public:
+  // Main search: all stages. killers may be null, the two killer moves otherwise.
+  MovePicker(const Board& b, Move ttMove, const Move* killers, const HistoryTable* history);
+  // Quiescence search: winning captures and promotions only, unless in check,
+  // where every evasion is returned.
+  MovePicker(const Board& b, bool inCheck);
+
+  // Next move, or an empty move when done
+  Move next();
+
+private:
+  enum Stage : uint8_t {
+    STAGE_TT, STAGE_GEN_CAPTURES, STAGE_CAPTURES, STAGE_KILLER_1, STAGE_KILLER_2,
+    STAGE_GEN_QUIETS, STAGE_QUIETS, STAGE_BAD_CAPTURES, STAGE_DONE
+  };
+
+  bool isSpecial(Move m) const;   // already returned by the TT or killer stage
+  void scoreCaptures();
+  void scoreQuiets();
+  Move pickBest();                // selection step over moves[cur..end)
+
+  const Board& b;
+  const HistoryTable* history;
+  Move ttMove{};
+  Move killer[2]{};
+  Stage stage;
+  bool deferBad{false};           // keep losing captures for the last stage
+  bool quiescence{false};         // stop after the captures, dropping losing ones
+
+  ScoredMove moves[MAX_MOVES];
+  int cur{0};
+  int end{0};
+  Move bad[MAX_MOVES];            // captures with negative SEE, tried last
+  int badCount{0};
+  int badCur{0};
+};
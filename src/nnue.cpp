@@ -0,0 +1,247 @@
+#include "nnue.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// File: nnue.cpp
+// Purpose: Network loading, accumulator updates and the output layer.
+// Notes:
+//  - Scores are clamped well inside the mate range so a bad network can
+//    never fake a mate.
+
+NnueNetwork NNUE;
+
+static const char NNUE_MAGIC[8] = { 'B', 'L', 'Z', 'N', 'N', 'U', 'E', '1' };
+static const size_t NNUE_HEADER_SIZE = 16;
+static const size_t NNUE_FILE_SIZE = NNUE_HEADER_SIZE
+  + sizeof(int16_t) * (size_t(NNUE_INPUTS) * NNUE_HIDDEN + NNUE_HIDDEN + 2 * NNUE_HIDDEN)
+  + sizeof(int32_t);
+
+static const int NNUE_MAX_SCORE = 30000;
+
+bool NnueNetwork::load(const std::string& path, std::string& error){
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0){ error = "cannot open " + path; return false; }
+  struct stat info;
+  if(::fstat(fd, &info) != 0 || size_t(info.st_size) != NNUE_FILE_SIZE){
+    ::close(fd);
+    error = "wrong size for a " + std::to_string(NNUE_HIDDEN) + "-wide network";
+    return false;
+  }
+  void* map = ::mmap(nullptr, NNUE_FILE_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping keeps the file open
+  if(map == MAP_FAILED){ error = "mmap failed"; return false; }
+
+  const char* bytes = static_cast<const char*>(map);
+  uint32_t hidden = 0;
+  std::memcpy(&hidden, bytes + 8, sizeof(hidden));
+  if(std::memcmp(bytes, NNUE_MAGIC, sizeof(NNUE_MAGIC)) != 0 || hidden != uint32_t(NNUE_HIDDEN)){
+    ::munmap(map, NNUE_FILE_SIZE);
+    error = "not a blitz network";
+    return false;
+  }
+
+  unload();
+  mapping = map;
+  mappedSize = NNUE_FILE_SIZE;
+  file = path;
+  // The header keeps every array 2-byte aligned. Kernels use unaligned loads.
+  featureWeights = reinterpret_cast<const int16_t*>(bytes + NNUE_HEADER_SIZE);
+  featureBias = featureWeights + size_t(NNUE_INPUTS) * NNUE_HIDDEN;
+  outputWeights = featureBias + NNUE_HIDDEN;
+  std::memcpy(&outputBias, outputWeights + 2 * NNUE_HIDDEN, sizeof(outputBias));
+  return true;
+}
+
+void NnueNetwork::unload(){
+  if(mapping) ::munmap(mapping, mappedSize);
+  mapping = nullptr;
+  mappedSize = 0;
+  file.clear();
+  featureWeights = featureBias = outputWeights = nullptr;
+  outputBias = 0;
+}
+
+// Input index of piece p on sq as seen by perspective persp. Black sees its
+// own pieces as the first six and the board flipped top to bottom.
+static inline int featureIndex(int persp, int p, int sq){
+  if(persp == BLACK){
+    p = p < 6 ? p + 6 : p - 6;
+    sq ^= 56;
+  }
+  return p * 64 + sq;
+}
+
+static inline const int16_t* column(int persp, int p, int sq){
+  return NNUE.featureWeights + size_t(featureIndex(persp, p, sq)) * NNUE_HIDDEN;
+}
+
+// Build both perspectives of a from the pieces on b
+static void refreshAccumulator(Accumulator& a, const Board& b){
+  for(int persp = WHITE; persp <= BLACK; ++persp){
+    int16_t* v = a.v[persp];
+    std::memcpy(v, NNUE.featureBias, sizeof(a.v[persp]));
+    for(int p = WP; p <= BK; ++p){
+      Bitboard bb = b.pcs[p];
+      while(bb){
+        const int16_t* w = column(persp, p, lsb(poplsb(bb)));
+        for(int i = 0; i < NNUE_HIDDEN; ++i) v[i] = int16_t(v[i] + w[i]);
+      }
+    }
+  }
+  a.key = b.key;
+  a.computed = true;
+}
+
+// Feature changes of one move: at most two added and two removed
+struct FeatureDelta {
+  int add[2][2];  // piece, square
+  int sub[2][2];
+  int adds{0};
+  int subs{0};
+};
+
+static FeatureDelta moveDelta(const State& st){
+  FeatureDelta d;
+  const Move m = st.last;
+  const int mover = st.moved;
+  const Color us = mover < 6 ? WHITE : BLACK;
+  const int from = m.from(), to = m.to();
+
+  d.sub[d.subs][0] = mover; d.sub[d.subs][1] = from; ++d.subs;
+  d.add[d.adds][0] = m.isPromo() ? promoPiece(m, us) : mover; d.add[d.adds][1] = to; ++d.adds;
+  if(m.isCastle()){
+    int rookFrom, rookTo;
+    castleRookSquares(to, rookFrom, rookTo);
+    const int rook = us == WHITE ? WR : BR;
+    d.sub[d.subs][0] = rook; d.sub[d.subs][1] = rookFrom; ++d.subs;
+    d.add[d.adds][0] = rook; d.add[d.adds][1] = rookTo; ++d.adds;
+  } else if(st.captured >= 0 && st.captured != NO_PIECE){
+    const int capSq = m.isEnPassant() ? (us == WHITE ? to - 8 : to + 8) : to;
+    d.sub[d.subs][0] = st.captured; d.sub[d.subs][1] = capSq; ++d.subs;
+  }
+  return d;
+}
+
+// to = from with the move recorded in st applied
+static void updateAccumulator(const Accumulator& from, Accumulator& to, const State& st){
+  if(st.moved == NO_PIECE){ // null move, no piece changed
+    std::memcpy(to.v, from.v, sizeof(to.v));
+    return;
+  }
+  const FeatureDelta d = moveDelta(st);
+  for(int persp = WHITE; persp <= BLACK; ++persp){
+    const int16_t* a0 = column(persp, d.add[0][0], d.add[0][1]);
+    const int16_t* s0 = column(persp, d.sub[0][0], d.sub[0][1]);
+    const int16_t* src = from.v[persp];
+    int16_t* dst = to.v[persp];
+    for(int i = 0; i < NNUE_HIDDEN; ++i) dst[i] = int16_t(src[i] + a0[i] - s0[i]);
+    if(d.adds > 1){
+      const int16_t* a1 = column(persp, d.add[1][0], d.add[1][1]);
+      for(int i = 0; i < NNUE_HIDDEN; ++i) dst[i] = int16_t(dst[i] + a1[i]);
+    }
+    if(d.subs > 1){
+      const int16_t* s1 = column(persp, d.sub[1][0], d.sub[1][1]);
+      for(int i = 0; i < NNUE_HIDDEN; ++i) dst[i] = int16_t(dst[i] - s1[i]);
+    }
+  }
+}
+
+// Sum of clippedReLU(us) . w[0..H) + clippedReLU(them) . w[H..2H)
+static int32_t outputLayer(const int16_t* us, const int16_t* them, const int16_t* w){
+#if defined(__AVX2__)
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i qa = _mm256_set1_epi16(NNUE_QA);
+  __m256i sum = _mm256_setzero_si256();
+  const int16_t* halves[2] = { us, them };
+  for(int h = 0; h < 2; ++h){
+    const int16_t* x = halves[h];
+    const int16_t* wh = w + h * NNUE_HIDDEN;
+    for(int i = 0; i < NNUE_HIDDEN; i += 16){
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+      v = _mm256_min_epi16(_mm256_max_epi16(v, zero), qa);
+      const __m256i wv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wh + i));
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, wv));
+    }
+  }
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+  return _mm_cvtsi128_si32(s);
+#elif defined(__ARM_NEON)
+  const int16x8_t zero = vdupq_n_s16(0);
+  const int16x8_t qa = vdupq_n_s16(NNUE_QA);
+  int32x4_t sum = vdupq_n_s32(0);
+  const int16_t* halves[2] = { us, them };
+  for(int h = 0; h < 2; ++h){
+    const int16_t* x = halves[h];
+    const int16_t* wh = w + h * NNUE_HIDDEN;
+    for(int i = 0; i < NNUE_HIDDEN; i += 8){
+      int16x8_t v = vminq_s16(vmaxq_s16(vld1q_s16(x + i), zero), qa);
+      const int16x8_t wv = vld1q_s16(wh + i);
+      sum = vmlal_s16(sum, vget_low_s16(v), vget_low_s16(wv));
+      sum = vmlal_s16(sum, vget_high_s16(v), vget_high_s16(wv));
+    }
+  }
+  return vaddvq_s32(sum);
+#else
+  int32_t sum = 0;
+  for(int i = 0; i < NNUE_HIDDEN; ++i){
+    sum += std::clamp<int32_t>(us[i], 0, NNUE_QA) * w[i];
+    sum += std::clamp<int32_t>(them[i], 0, NNUE_QA) * w[NNUE_HIDDEN + i];
+  }
+  return sum;
+#endif
+}
+
+static int score(const Accumulator& a, Color stm){
+  const int64_t out = int64_t(outputLayer(a.v[stm], a.v[~stm], NNUE.outputWeights)) + NNUE.outputBias;
+  const int64_t cp = out * NNUE_SCALE / (NNUE_QA * NNUE_QB);
+  return int(std::clamp<int64_t>(cp, -NNUE_MAX_SCORE, NNUE_MAX_SCORE));
+}
+
+void NnueStack::reset(const Board& b, const StateStack& states){
+  base = states.size();
+  for(Accumulator& a : acc) a.computed = false;
+  refreshAccumulator(acc[0], b);
+}
+
+int NnueStack::evaluate(const Board& b, const StateStack& states){
+  const int n = states.size() - base;
+  if(n < 0 || n >= NNUE_STACK_SIZE){
+    refreshAccumulator(scratch, b);
+    return score(scratch, b.stm);
+  }
+
+  // Key of the position at entry i, for i < n
+  auto keyAt = [&](int i){ return states[base + i].prevKey; };
+  if(!(acc[n].computed && acc[n].key == b.key)){
+    int j = n - 1;
+    while(j >= 0 && !(acc[j].computed && acc[j].key == keyAt(j))) --j;
+    if(j < 0){
+      refreshAccumulator(acc[n], b);
+    } else {
+      for(int i = j; i < n; ++i){
+        updateAccumulator(acc[i], acc[i + 1], states[base + i]);
+        acc[i + 1].key = i + 1 == n ? b.key : keyAt(i + 1);
+        acc[i + 1].computed = true;
+      }
+    }
+  }
+
+#ifndef NDEBUG
+  Accumulator check;
+  refreshAccumulator(check, b);
+  assert(std::memcmp(check.v, acc[n].v, sizeof(check.v)) == 0);
+#endif
+  return score(acc[n], b.stm);
+}
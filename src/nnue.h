@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "board.h"
+
+// File: nnue.h
+// Purpose: Optional neural evaluation with incrementally updated accumulators.
+// Notes:
+//  - Network: 768 inputs (piece x square) -> NNUE_HIDDEN per perspective,
+//    clipped ReLU, then one output over both halves, side to move first.
+//  - Each perspective sees the board from its own side: Black's features
+//    are color swapped and rank mirrored, so one weight set serves both.
+//  - Accumulators are updated lazily. makeMove records the moving and
+//    captured pieces in its State. When a node is evaluated, the nearest
+//    ancestor accumulator still valid is walked forward by adding and
+//    subtracting feature columns. An accumulator is tagged with its
+//    position's key, so a stale entry is never reused.
+//  - The output layer uses AVX2 or NEON int16 multiply-adds when the build
+//    targets them, scalar code otherwise. Accumulator updates are plain
+//    loops over a fixed width, which the compiler vectorizes.
+//  - With no network loaded the search uses the hand-crafted eval().
+//
+// File format, little endian:
+//   char    magic[8]  "BLZNNUE1"
+//   uint32  hidden    must equal NNUE_HIDDEN
+//   uint32  reserved  0
+//   int16   featureWeights[768][hidden]
+//   int16   featureBias[hidden]
+//   int16   outputWeights[2 * hidden]   side to move half first
+//   int32   outputBias
+// Accumulator values are in units of 1/NNUE_QA, output weights 1/NNUE_QB.
+// The score is (output + bias) * NNUE_SCALE / (NNUE_QA * NNUE_QB) centipawns.
+
+constexpr int NNUE_INPUTS = 768;
+constexpr int NNUE_HIDDEN = 256;
+constexpr int NNUE_QA = 255;
+constexpr int NNUE_QB = 64;
+constexpr int NNUE_SCALE = 400;
+
+// Loaded network weights. The file is mapped read-only and never copied.
+class NnueNetwork {
+public:
+  NnueNetwork() = default;
+  NnueNetwork(const NnueNetwork&) = delete;
+  NnueNetwork& operator=(const NnueNetwork&) = delete;
+  ~NnueNetwork(){ unload(); }
+
+  // Map and validate path. On error returns false with a reason in error,
+  // and the previous network, if any, stays loaded.
+  bool load(const std::string& path, std::string& error);
+  void unload();
+  bool loaded() const { return mapping != nullptr; }
+  const std::string& path() const { return file; }
+
+  const int16_t* featureWeights{nullptr};
+  const int16_t* featureBias{nullptr};
+  const int16_t* outputWeights{nullptr};
+  int32_t outputBias{0};
+
+private:
+  void* mapping{nullptr};
+  size_t mappedSize{0};
+  std::string file;
+};
+
+// Network used by the search. Only load or unload it while no search runs.
+extern NnueNetwork NNUE;
+
+// First-layer output for both perspectives, WHITE and BLACK
+struct alignas(64) Accumulator {
+  int16_t v[2][NNUE_HIDDEN];
+  uint64_t key{0};      // position these values belong to
+  bool computed{false};
+};
+
+// Accumulators along one search line. Entry i belongs to the position after
+// the first i moves past the root of the StateStack it is used with.
+constexpr int NNUE_STACK_SIZE = 160;
+
+class NnueStack {
+public:
+  // Start a search at b. states holds the moves that led to it.
+  void reset(const Board& b, const StateStack& states);
+  // Network score of b from the side to move's view. states must extend, by
+  // the moves played since reset, the stack given to reset.
+  int evaluate(const Board& b, const StateStack& states);
+
+private:
+  Accumulator acc[NNUE_STACK_SIZE];
+  Accumulator scratch;  // used past the end of the stack
+  int base{0};
+};
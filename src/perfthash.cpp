@@ -0,0 +1,58 @@
+#include <initializer_list>
+#include "perfthash.h"
+
+// File: perfthash.cpp
+// Purpose: Perft count cache storage and lookup.
+
+void PerftHash::resize(size_t mb){
+  count = 0;
+  buckets.reset();
+  if(mb > 0){
+    size_t bytes = mb * 1024 * 1024;
+    size_t n = 1;
+    while(n * 2 * sizeof(Bucket) <= bytes) n *= 2;
+    buckets = std::make_unique<Bucket[]>(n);
+    count = n;
+    mask = n - 1;
+  }
+  clear();
+}
+
+void PerftHash::clear(){
+  for(size_t i = 0; i < count; ++i){
+    for(Slot* s : { &buckets[i].deep, &buckets[i].recent }){
+      s->keyXorData.store(0, std::memory_order_relaxed);
+      s->data.store(0, std::memory_order_relaxed);
+    }
+  }
+  probeCount.store(0, std::memory_order_relaxed);
+  hitCount.store(0, std::memory_order_relaxed);
+}
+
+bool PerftHash::probe(uint64_t key, int depth, unsigned long long& nodes) const{
+  if(!count) return false;
+  const Bucket& bk = buckets[key & mask];
+  for(const Slot* s : { &bk.deep, &bk.recent }){
+    uint64_t d = s->data.load(std::memory_order_relaxed);
+    if((s->keyXorData.load(std::memory_order_relaxed) ^ d) == key && int(d & 0xFF) == depth){
+      nodes = d >> 8;
+      return true;
+    }
+  }
+  return false;
+}
+
+void PerftHash::store(uint64_t key, int depth, unsigned long long nodes){
+  if(!count) return;
+  Bucket& bk = buckets[key & mask];
+  const uint64_t d = (uint64_t(nodes) << 8) | uint64_t(depth & 0xFF);
+  const int deepDepth = int(bk.deep.data.load(std::memory_order_relaxed) & 0xFF);
+  Slot& s = (depth >= deepDepth) ? bk.deep : bk.recent;
+  s.keyXorData.store(key ^ d, std::memory_order_relaxed);
+  s.data.store(d, std::memory_order_relaxed);
+}
+
+void PerftHash::addStats(unsigned long long probes, unsigned long long hits){
+  probeCount.fetch_add(probes, std::memory_order_relaxed);
+  hitCount.fetch_add(hits, std::memory_order_relaxed);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// File: perfthash.h
+// Purpose: Hash table of perft subtree counts keyed by position and depth.
+// Notes:
+//  - Separate from the search TT so a perft run never evicts search entries
+//    and the two can be sized independently.
+//  - Lockless like the TT: a slot holds data and key^data, data being the
+//    count shifted left 8 bits with the depth in the low byte. Threaded
+//    perft shares one table.
+//  - Buckets hold two slots: one kept for the deepest entry seen, one
+//    always replaced.
+
+class PerftHash {
+public:
+  void resize(size_t mb);   // 0 disables the table
+  void clear();
+  bool enabled() const { return count != 0; }
+  bool probe(uint64_t key, int depth, unsigned long long& nodes) const;
+  void store(uint64_t key, int depth, unsigned long long nodes);
+  size_t sizeMB() const { return count * sizeof(Bucket) / (1024 * 1024); }
+
+  // Hit statistics, added to by perft once per worker
+  void addStats(unsigned long long probes, unsigned long long hits);
+  unsigned long long probes() const { return probeCount.load(std::memory_order_relaxed); }
+  unsigned long long hits() const { return hitCount.load(std::memory_order_relaxed); }
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> keyXorData{0};
+    std::atomic<uint64_t> data{0};
+  };
+  struct alignas(32) Bucket {
+    Slot deep;     // replaced only by an entry at least as deep
+    Slot recent;   // always replaced
+  };
+
+  std::unique_ptr<Bucket[]> buckets;
+  size_t count{0};
+  uint64_t mask{0};
+  std::atomic<unsigned long long> probeCount{0};
+  std::atomic<unsigned long long> hitCount{0};
+};
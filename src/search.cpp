@@ -1,164 +1,613 @@
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <thread>
 #include <vector>
 #include "search.h"
 #include "eval.h"
 #include "bitboard.h"
+#include "tt.h"
+#include "movepick.h"
+#include "nnue.h"
 
 // File: search.cpp
 // Purpose: Game tree search helpers and root search. Uses negamax with alpha-beta.
 // Notes:
 //  - Scores are from the side to move perspective.
-//  - Captures are ordered by MVV-LVA to improve pruning.
-//  - Principal variation is built at the root only.
+//  - Moves come from a staged MovePicker: TT move, winning captures,
+//    killers, quiets by history, losing captures.
+//  - search_root() deepens iteratively with aspiration windows.
+//  - The principal variation is collected in a triangular table during the
+//    search, so building it costs no extra nodes.
+//  - Interior nodes probe and store the transposition table. A stored move
+//    is searched first. Mate scores are kept relative to the node in the TT.
+//  - Static evals come from the neural network when one is loaded, else
+//    from the hand-crafted eval().
+//  - Leaves run a captures-only quiescence search with stand pat, delta
+//    pruning and SEE filtering of losing captures.
+//  - nodes counts every negamax and quiescence call.
+//  - Principal variation search: after the first move, moves are searched
+//    with a null window and re-searched with the full one only if they
+//    beat alpha. Nodes with a null window are non-PV nodes.
+//  - Selective search at non-PV nodes, each part switchable by
+//    SearchFeatures: reverse futility and null-move pruning before the move
+//    loop, forward futility pruning of quiet moves near the leaves, and
+//    late-move reductions for quiet moves the picker hands out late. Moves
+//    that give check are never pruned or reduced.
+//  - Below the root, a repetition or a fifty-move position scores as a draw
+//    at once. One repetition is enough: the side that could have avoided it
+//    chose not to.
+//  - Lazy SMP: with threads > 1, helper threads run their own iterative
+//    deepening on private board copies and meet the main thread only through
+//    the shared TT. Odd helpers start one ply deeper so the threads spread
+//    over depths. The main thread alone reports, and stops the helpers when
+//    it finishes. An aborted node returns at once and stores nothing.
+//  - All threads watch a stop flag owned by search_root(), and the caller's
+//    flag if one was given. The main thread raises its own flag on the hard
+//    time limit or node budget and when the search ends. The caller's flag
+//    is only read, so the caller can still tell its own stop from a search
+//    that finished. An aborted iteration is discarded and the previous one
+//    is reported.
+//  - The flags and the clock are polled every POLL_INTERVAL nodes. Between
+//    polls a thread tests only its own aborted bool.
+//  - BLITZ_STATS builds count TT use, cutoffs and quiescence nodes per
+//    thread and time move picking and eval. The totals land in
+//    SearchResult::stats.
 
-// Value used for MVV scoring
-static inline int pieceValueForMVV(int p){
-  switch(p){
-    case WP: case BP: return 100;
-    case WN: case BN: return 320;
-    case WB: case BB: return 330;
-    case WR: case BR: return 500;
-    case WQ: case BQ: return 900;
-    default: return 0;
-  }
+// Score bound wider than any real score
+static const int INF_SCORE = 10000000;
+
+// Aspiration windows start at this half width from depth ASPIRATION_MIN_DEPTH,
+// double on every fail and fall back to a full window past the max
+static const int ASPIRATION_DELTA = 25;
+static const int ASPIRATION_MIN_DEPTH = 4;
+static const int ASPIRATION_MAX_DELTA = 1000;
+
+// Delta pruning margin. A capture that cannot lift the score within this of
+// alpha, even winning the victim outright, is skipped.
+static const int DELTA_MARGIN = 200;
+
+// Convert a mate score from root-relative to node-relative before storing
+static inline int scoreToTT(int score, int ply){
+  if(score >  MATE_BOUND) return score + ply;
+  if(score < -MATE_BOUND) return score - ply;
+  return score;
 }
 
-// True if move m captures an opponent piece or is en passant
-static inline bool isCapture(const Board& b, const Move& m){
-  Color us = b.stm;
-  Color them = (us == WHITE) ? BLACK : WHITE;
-  Bitboard toMask = 1ULL << m.to;
-  return (b.occ[them] & toMask) != 0 || (m.flags & MF_ENPASSANT);
+// Convert a stored mate score back to root-relative at this ply
+static inline int scoreFromTT(int score, int ply){
+  if(score >  MATE_BOUND) return score - ply;
+  if(score < -MATE_BOUND) return score + ply;
+  return score;
 }
 
-// Most Valuable Victim, Least Valuable Attacker score for move ordering
-static inline int mvvLva(const Board& b, const Move& m){
-  if(!isCapture(b, m)) return 0;
-  int victim = b.piece_at(m.to);
-  if(m.flags & MF_ENPASSANT) victim = (b.stm == WHITE) ? BP : WP;
-  int attacker = b.piece_at(m.from);
-  return pieceValueForMVV(victim) * 10 - pieceValueForMVV(attacker);
+// Nodes between polls of the stop flag and the clock. At several million
+// nodes per second this keeps overshoot well under a millisecond.
+static const unsigned long long POLL_INTERVAL = 1024;
+
+// Reverse futility: a static eval this far above beta per ply of remaining
+// depth returns at once, up to RFP_MAX_DEPTH
+static const int RFP_MARGIN = 120;
+static const int RFP_MAX_DEPTH = 3;
+
+// Null-move pruning from this depth. The reduction is NULL_MOVE_R plus one
+// per NULL_MOVE_R_DIV plies of depth.
+static const int NULL_MOVE_MIN_DEPTH = 3;
+static const int NULL_MOVE_R = 2;
+static const int NULL_MOVE_R_DIV = 4;
+
+// Forward futility: at depth d up to FUTILITY_MAX_DEPTH, quiet moves are
+// skipped when the static eval plus FUTILITY_MARGIN[d] cannot reach alpha
+static const int FUTILITY_MAX_DEPTH = 2;
+static const int FUTILITY_MARGIN[FUTILITY_MAX_DEPTH + 1] = {0, 150, 300};
+
+// Late-move reductions from this depth, for moves after the first LMR_MIN_MOVES
+static const int LMR_MIN_DEPTH = 3;
+static const int LMR_MIN_MOVES = 3;
+
+// History values stay within +-HISTORY_MAX, so they fit a ScoredMove score
+static const int HISTORY_MAX = 16384;
+
+// Per-thread search state threaded through negamax
+struct SearchContext {
+  // Written only by the owning thread, read by the main thread for totals
+  std::atomic<unsigned long long> nodes{0};
+  // Stop flag of this search, raised by the main thread
+  std::atomic<bool>* stop{nullptr};
+  // The caller's stop flag, or null. Read only.
+  const std::atomic<bool>* external{nullptr};
+  // Table shared by all threads of this search
+  TranspositionTable* tt{nullptr};
+  // Set once this thread has seen the stop, every node returns after that
+  bool aborted{false};
+  // Limits enforced by the main thread only
+  bool isMain{false};
+  std::chrono::steady_clock::time_point start{};
+  int64_t hardMs{-1};
+  unsigned long long nodeLimit{0};
+  // Triangular PV table. pv[ply] holds the best line found from ply onward,
+  // in pv[ply][ply .. pvLength[ply]-1].
+  Move pv[MAX_PLY + 1][MAX_PLY + 1];
+  int pvLength[MAX_PLY + 1];
+  // Two quiet moves per ply that recently caused a beta cutoff
+  Move killers[MAX_PLY + 2][2]{};
+  // Quiet move history per side, raised for moves that cause cutoffs
+  HistoryTable history[2]{};
+  // Selective search switches for this search
+  SearchFeatures features;
+  // Moves from the game and the current search line, for repetitions
+  StateStack states;
+  // Neural eval accumulators along the search line, used if a network is loaded
+  bool useNnue{false};
+  NnueStack nnue;
+  // Counters for BLITZ_STATS builds, untouched otherwise
+  SearchStats stats;
+};
+
+static inline int64_t elapsedMs(const SearchContext& ctx){
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - ctx.start).count();
 }
 
-// Negamax with alpha-beta pruning
-// Returns a score from the side to move perspective
-static int negamax(Board& b, int depth, int alpha, int beta, unsigned long long& nodeCount){
-  if(depth == 0){
-    ++nodeCount;
-    return eval(b);
+// Raise the search's stop flag for every thread and abort this one
+static inline void raiseStop(SearchContext& ctx){
+  ctx.stop->store(true, std::memory_order_relaxed);
+  ctx.aborted = true;
+}
+
+// Look at the stop flags and, on the main thread, the hard time limit
+static inline void pollStop(SearchContext& ctx){
+  if(ctx.stop->load(std::memory_order_relaxed) ||
+     (ctx.external && ctx.external->load(std::memory_order_relaxed))) ctx.aborted = true;
+  else if(ctx.isMain && ctx.hardMs >= 0 && elapsedMs(ctx) >= ctx.hardMs) raiseStop(ctx);
+}
+
+// Count a node. Only the owner writes, so a plain add is enough. The node
+// budget is exact, the flag and the clock are polled every POLL_INTERVAL.
+static inline void countNode(SearchContext& ctx){
+  const unsigned long long n = ctx.nodes.load(std::memory_order_relaxed) + 1;
+  ctx.nodes.store(n, std::memory_order_relaxed);
+  if(ctx.isMain && ctx.nodeLimit && n >= ctx.nodeLimit) raiseStop(ctx);
+  if((n & (POLL_INTERVAL - 1)) == 0) pollStop(ctx);
+}
+
+static inline bool stopped(const SearchContext& ctx){
+  return ctx.aborted;
+}
+
+// Credit a quiet move that caused a beta cutoff at ply with remaining depth.
+// The bonus shrinks as the entry nears HISTORY_MAX, keeping it bounded.
+static inline void updateQuietStats(SearchContext& ctx, const Board& b, int ply, int depth, const Move& mv){
+  if(!(ctx.killers[ply][0] == mv)){
+    ctx.killers[ply][1] = ctx.killers[ply][0];
+    ctx.killers[ply][0] = mv;
   }
+  int16_t& h = ctx.history[b.stm][mv.from()][mv.to()];
+  const int bonus = std::min(depth * depth, HISTORY_MAX);
+  h = int16_t(h + bonus - h * bonus / HISTORY_MAX);
+}
 
-  std::vector<Move> legalMoves;
-  generateMoves(b, legalMoves);
+// Static eval: the network when one is loaded, else the hand-crafted eval
+static inline int evaluate(const Board& b, SearchContext& ctx){
+  StatsTimer timer(ctx.stats.evalNs);
+  return ctx.useNnue ? ctx.nnue.evaluate(b, ctx.states) : eval(b);
+}
 
-  // No legal moves, checkmate or stalemate
-  if(legalMoves.empty()){
-    ++nodeCount;
-    if(b.inCheck(b.stm)){
-      return -100000 + b.ply; // checkmate, prefer faster mates for the winner
-    }
-    return 0; // stalemate
+// Late-move reduction by remaining depth and move number, both capped at 63.
+// Grows with the log of each, so late moves at high depth lose the most.
+static int lmrReduction(int depth, int moveNumber){
+  static const auto table = []{
+    std::vector<std::vector<int>> t(64, std::vector<int>(64, 0));
+    for(int d = 1; d < 64; ++d)
+      for(int m = 1; m < 64; ++m) t[d][m] = int(0.75 + std::log(d) * std::log(m) / 2.25);
+    return t;
+  }();
+  return table[std::min(depth, 63)][std::min(moveNumber, 63)];
+}
+
+// True if the side to move has a piece other than pawns and the king. Without
+// one, zugzwang is common and a null move proves nothing.
+static inline bool hasNonPawnMaterial(const Board& b){
+  const int base = b.stm == WHITE ? WN : BN;
+  return (b.pcs[base] | b.pcs[base + 1] | b.pcs[base + 2] | b.pcs[base + 3]) != 0;
+}
+
+// Next move from the picker, timed in stats builds
+static inline Move nextMove(MovePicker& picker, SearchContext& ctx){
+  StatsTimer timer(ctx.stats.movegenNs);
+  return picker.next();
+}
+
+// Store in the TT, counting entries of other positions overwritten
+static inline void storeTT(SearchContext& ctx, uint64_t key, int depth, Bound bound, int score, Move move){
+  const bool evicted = ctx.tt->store(key, depth, bound, score, move);
+  if constexpr(SEARCH_STATS) ctx.stats.ttCollisions += evicted;
+}
+
+// Record mv followed by the child's line as the PV at ply
+static inline void updatePv(SearchContext& ctx, int ply, const Move& mv){
+  ctx.pv[ply][ply] = mv;
+  for(int i = ply + 1; i < ctx.pvLength[ply + 1]; ++i) ctx.pv[ply][i] = ctx.pv[ply + 1][i];
+  ctx.pvLength[ply] = std::max(ctx.pvLength[ply + 1], ply + 1);
+}
+
+// Quiescence search. Resolves captures and promotions until the position is
+// quiet, so leaves are not scored in the middle of an exchange. In check
+// every evasion is searched and there is no stand pat.
+static int quiesce(Board& b, SearchContext& ctx, int ply, int alpha, int beta){
+  countNode(ctx);
+  if constexpr(SEARCH_STATS) ++ctx.stats.qnodes;
+  if(stopped(ctx)) return 0;
+  ctx.pvLength[ply] = ply;
+  if(ply >= MAX_PLY) return evaluate(b, ctx);
+  if(b.isDraw(ctx.states)) return 0;
+
+  const bool inCheck = b.inCheck(b.stm);
+  int standPat = -INF_SCORE;
+  if(!inCheck){
+    standPat = evaluate(b, ctx);
+    if(standPat >= beta) return standPat;
+    if(standPat > alpha) alpha = standPat;
   }
 
-  // Order moves, captures first by MVV-LVA
-  std::stable_sort(legalMoves.begin(), legalMoves.end(), [&](const Move& a, const Move& z){
-    return mvvLva(b, a) > mvvLva(b, z);
-  });
+  // Winning captures and promotions, or every evasion when in check
+  MovePicker picker(b, inCheck);
+  int bestScore = standPat;
+  int played = 0;
+  for(Move mv = nextMove(picker, ctx); !mv.isNone(); mv = nextMove(picker, ctx)){
+    ++played;
+    // Delta pruning, promotions can gain too much to skip this way
+    if(!inCheck && !mv.isPromo()){
+      int victim = mv.isEnPassant() ? WP : b.piece_at(mv.to());
+      if(standPat + PIECE_VALUE[victim] + DELTA_MARGIN <= alpha) continue;
+    }
 
-  int bestScore = -10000000;
-  for(const Move& mv : legalMoves){
-    b.makeMove(mv);
-    int score = -negamax(b, depth - 1, -beta, -alpha, nodeCount);
-    b.unmakeMove(mv);
+    b.makeMove(mv, ctx.states);
+    int score = -quiesce(b, ctx, ply + 1, -beta, -alpha);
+    b.unmakeMove(mv, ctx.states);
+    if(stopped(ctx)) return 0;
 
     if(score > bestScore) bestScore = score;
-    if(score > alpha) alpha = score;
-    if(alpha >= beta) break; // beta cutoff
+    if(score > alpha){
+      alpha = score;
+      updatePv(ctx, ply, mv);
+    }
+    if(alpha >= beta) break;
   }
+  if(inCheck && played == 0) return -MATE_SCORE + ply; // checkmate
   return bestScore;
 }
 
-// Choose the single best move in the given position for a given depth
-// Used to build the root principal variation without threading PV through all nodes
-static Move chooseBestMove(Board& b, int depth, unsigned long long& nodeCount){
-  std::vector<Move> legalMoves;
-  generateMoves(b, legalMoves);
-  if(legalMoves.empty()) return Move{};
+// Negamax with alpha-beta pruning
+// Returns a score from the side to move perspective. ply is the distance from the root.
+static int negamax(Board& b, SearchContext& ctx, int depth, int ply, int alpha, int beta){
+  if(depth <= 0 || ply >= MAX_PLY) return quiesce(b, ctx, ply, alpha, beta);
+  countNode(ctx);
+  if(stopped(ctx)) return 0;
+  ctx.pvLength[ply] = ply;
+  if(b.isDraw(ctx.states)) return 0;
+
+  // Transposition table probe. A deep enough entry can end the node.
+  const uint64_t key = b.key;
+  const int alphaOrig = alpha;
+  Move ttMove{};
+  TTEntry tte;
+  const bool ttHit = ctx.tt->probe(key, tte);
+  if constexpr(SEARCH_STATS){ ++ctx.stats.ttProbes; ctx.stats.ttHits += ttHit; }
+  if(ttHit){
+    ttMove = tte.move;
+    if(tte.depth >= depth){
+      int ttScore = scoreFromTT(tte.score, ply);
+      if(tte.bound() == BOUND_EXACT ||
+         (tte.bound() == BOUND_LOWER && ttScore >= beta) ||
+         (tte.bound() == BOUND_UPPER && ttScore <= alpha)){
+        return ttScore;
+      }
+    }
+  }
+
+  const bool pvNode = beta - alpha > 1;
+  const bool inCheck = b.inCheck(b.stm);
+  const int staticEval = inCheck ? -INF_SCORE : evaluate(b, ctx);
+  const bool quietWindow = std::abs(beta) < MATE_BOUND && std::abs(alpha) < MATE_BOUND;
+
+  if(!pvNode && !inCheck && quietWindow){
+    // Reverse futility: far enough above beta that no quiet reply will matter
+    if(ctx.features.futility && depth <= RFP_MAX_DEPTH && staticEval - RFP_MARGIN * depth >= beta){
+      return staticEval;
+    }
+
+    // Null move: if passing still fails high, a real move would too. Never
+    // twice in a row, which would only hand the turn back.
+    const bool afterNull = ctx.states.size() > 0 && ctx.states.top().last.isNone();
+    if(ctx.features.nullMove && depth >= NULL_MOVE_MIN_DEPTH && staticEval >= beta &&
+       !afterNull && hasNonPawnMaterial(b)){
+      const int r = NULL_MOVE_R + depth / NULL_MOVE_R_DIV;
+      b.makeNullMove(ctx.states);
+      int score = -negamax(b, ctx, depth - 1 - r, ply + 1, -beta, -beta + 1);
+      b.unmakeNullMove(ctx.states);
+      if(stopped(ctx)) return 0;
+      if(score >= beta) return score >= MATE_BOUND ? beta : score; // unproven mates stay out
+    }
+  }
 
-  std::stable_sort(legalMoves.begin(), legalMoves.end(), [&](const Move& a, const Move& z){
-    return mvvLva(b, a) > mvvLva(b, z);
-  });
+  // Quiet moves that cannot lift the score to alpha are skipped near the leaves
+  const bool futile = ctx.features.futility && !pvNode && !inCheck && quietWindow &&
+                      depth <= FUTILITY_MAX_DEPTH && staticEval + FUTILITY_MARGIN[depth] <= alpha;
 
-  int alpha = -10000000;
-  int beta  =  10000000;
-  int bestScore = -10000000;
+  MovePicker picker(b, ttMove, ctx.killers[ply], &ctx.history[b.stm]);
+  int bestScore = -INF_SCORE;
   Move bestMove{};
+  int played = 0;
+  for(Move mv = nextMove(picker, ctx); !mv.isNone(); mv = nextMove(picker, ctx)){
+    ++played;
+    const bool quiet = !mv.isCapture() && !mv.isPromo();
+    b.makeMove(mv, ctx.states);
+    const bool givesCheck = quiet && !inCheck && b.inCheck(b.stm);
+
+    // Forward futility, always keeping one searched move for the score
+    if(futile && quiet && !givesCheck && played > 1){
+      b.unmakeMove(mv, ctx.states);
+      continue;
+    }
 
-  for(const Move& mv : legalMoves){
-    b.makeMove(mv);
-    int score = -negamax(b, depth - 1, -beta, -alpha, nodeCount);
-    b.unmakeMove(mv);
+    int score;
+    if(played == 1){
+      score = -negamax(b, ctx, depth - 1, ply + 1, -beta, -alpha);
+    } else {
+      // Late quiet moves are searched shallower first
+      int r = 0;
+      if(ctx.features.lmr && quiet && !inCheck && !givesCheck &&
+         depth >= LMR_MIN_DEPTH && played > LMR_MIN_MOVES){
+        r = lmrReduction(depth, played);
+        if(pvNode) --r;
+        if(mv == ctx.killers[ply][0] || mv == ctx.killers[ply][1]) --r;
+        r = std::clamp(r, 0, depth - 2);
+      }
+      score = -negamax(b, ctx, depth - 1 - r, ply + 1, -alpha - 1, -alpha);
+      if(score > alpha && r > 0) score = -negamax(b, ctx, depth - 1, ply + 1, -alpha - 1, -alpha);
+      if(score > alpha && score < beta) score = -negamax(b, ctx, depth - 1, ply + 1, -beta, -alpha);
+    }
+    b.unmakeMove(mv, ctx.states);
+    if(stopped(ctx)) return 0; // partial result, keep it out of the TT
 
     if(score > bestScore){
       bestScore = score;
       bestMove = mv;
     }
-    if(score > alpha) alpha = score;
+    if(score > alpha){
+      alpha = score;
+      updatePv(ctx, ply, mv);
+    }
+    if(alpha >= beta){ // beta cutoff
+      if constexpr(SEARCH_STATS){ ++ctx.stats.cutoffs; ctx.stats.firstCutoffs += played == 1; }
+      if(quiet) updateQuietStats(ctx, b, ply, depth, mv);
+      break;
+    }
   }
-  return bestMove;
-}
 
-// Root search, builds a one-line principal variation by walking best replies
-SearchResult search_root(Board& b, int depth){
-  SearchResult out{};
-  out.nodes = 0ULL;
+  // No legal moves, checkmate or stalemate
+  if(played == 0){
+    if(inCheck){
+      return -MATE_SCORE + ply; // checkmate, prefer faster mates for the winner
+    }
+    return 0; // stalemate
+  }
+  if constexpr(SEARCH_STATS) ++ctx.stats.searched;
 
-  std::vector<Move> legalMoves;
-  generateMoves(b, legalMoves);
+  Bound bound = bestScore >= beta ? BOUND_LOWER : (bestScore > alphaOrig ? BOUND_EXACT : BOUND_UPPER);
+  storeTT(ctx, key, depth, bound, scoreToTT(bestScore, ply), bound == BOUND_UPPER ? Move{} : bestMove);
+  return bestScore;
+}
 
-  std::stable_sort(legalMoves.begin(), legalMoves.end(), [&](const Move& a, const Move& z){
-    return mvvLva(b, a) > mvvLva(b, z);
-  });
+// Search every root move inside (alpha, beta). The move in bestMove, from the
+// previous iteration, is searched first. Returns a fail-soft score.
+static int searchRoot(Board& b, SearchContext& ctx, int depth, int alpha, int beta, Move& bestMove){
+  // The previous iteration's best move goes first, else the stored one
+  Move first = bestMove;
+  TTEntry rootEntry;
+  if(first.isNone() && ctx.tt->probe(b.key, rootEntry)) first = rootEntry.move;
+  MovePicker picker(b, first, ctx.killers[0], &ctx.history[b.stm]);
 
-  int alpha = -10000000;
-  int beta  =  10000000;
-  int bestScore = -10000000;
-  Move bestMove{};
+  const int alphaOrig = alpha;
+  int bestScore = -INF_SCORE;
+  Move best{};
+  ctx.pvLength[0] = 0;
 
-  for(const Move& mv : legalMoves){
-    b.makeMove(mv);
-    unsigned long long childNodes = 0ULL;
-    int score = -negamax(b, depth - 1, -beta, -alpha, childNodes);
-    b.unmakeMove(mv);
+  int searched = 0;
+  for(Move mv = nextMove(picker, ctx); !mv.isNone(); mv = nextMove(picker, ctx)){
+    b.makeMove(mv, ctx.states);
+    int score;
+    if(searched++ == 0){
+      score = -negamax(b, ctx, depth - 1, 1, -beta, -alpha);
+    } else {
+      score = -negamax(b, ctx, depth - 1, 1, -alpha - 1, -alpha);
+      if(score > alpha && score < beta) score = -negamax(b, ctx, depth - 1, 1, -beta, -alpha);
+    }
+    b.unmakeMove(mv, ctx.states);
+    if(stopped(ctx)) return 0;
 
-    out.nodes += childNodes;
     if(score > bestScore){
       bestScore = score;
-      bestMove = mv;
+      best = mv;
+      // On a fail low nothing beats alpha, keep at least the best move
+      if(score <= alpha){ ctx.pv[0][0] = mv; ctx.pvLength[0] = 1; }
+    }
+    if(score > alpha){
+      alpha = score;
+      updatePv(ctx, 0, mv);
+    }
+    if(alpha >= beta) break; // fail high, the driver widens the window
+  }
+
+  bestMove = best;
+  Bound bound = bestScore >= beta ? BOUND_LOWER : (bestScore > alphaOrig ? BOUND_EXACT : BOUND_UPPER);
+  storeTT(ctx, b.key, depth, bound, bestScore, best); // mate distances at the root need no adjustment
+  return bestScore;
+}
+
+// A TT cutoff ends the triangular PV early. Extend it by following stored
+// moves while they are legal, without searching.
+static void extendPvFromTT(const TranspositionTable& tt, const Board& b, std::vector<Move>& pv, int depth){
+  Board walk = b; // copy-make along the line, nothing to undo
+  State st;
+  for(const Move& m : pv) walk.makeMove(m, st);
+  while((int)pv.size() < depth){
+    TTEntry tte;
+    if(!tt.probe(walk.key, tte) || tte.move.isNone()) break;
+    MoveList legal;
+    generateMoves(walk, legal);
+    if(std::find(legal.begin(), legal.end(), tte.move) == legal.end()) break;
+    pv.push_back(tte.move);
+    walk.makeMove(tte.move, st);
+  }
+}
+
+// One iteration at depth d inside an aspiration window around prevScore.
+// The window doubles on every fail and opens fully past the max.
+static int aspirationSearch(Board& b, SearchContext& ctx, int d, int prevScore, Move& bestMove){
+  int delta = ASPIRATION_DELTA;
+  int alpha = -INF_SCORE, beta = INF_SCORE;
+  if(d >= ASPIRATION_MIN_DEPTH && std::abs(prevScore) < MATE_BOUND){
+    alpha = prevScore - delta;
+    beta = prevScore + delta;
+  }
+
+  for(;;){
+    int score = searchRoot(b, ctx, d, alpha, beta, bestMove);
+    if(stopped(ctx)) return score;
+    if(score <= alpha && alpha > -INF_SCORE){
+      beta = (alpha + beta) / 2;
+      alpha = std::max(score - delta, -INF_SCORE);
+    } else if(score >= beta && beta < INF_SCORE){
+      beta = std::min(score + delta, INF_SCORE);
+    } else {
+      return score;
     }
-    if(score > alpha) alpha = score;
+    delta *= 2;
+    if(delta > ASPIRATION_MAX_DELTA){ alpha = -INF_SCORE; beta = INF_SCORE; }
   }
+}
 
-  out.best = bestMove;
-  out.score = bestScore;
+// Seed a thread's state stack with the game moves a repetition can reach:
+// those since the last irreversible move. Past 100 of them the fifty-move
+// rule already scores every node a draw. With a network loaded, the root
+// accumulator is built here too.
+static void initStates(SearchContext& ctx, const Board& b, const SearchLimits& limits){
+  if(limits.history) ctx.states.assignTail(*limits.history, std::min(b.halfmoveClock, 100));
+  else ctx.states.clear();
+  ctx.useNnue = NNUE.loaded();
+  if(ctx.useNnue) ctx.nnue.reset(b, ctx.states);
+}
+
+// Helper thread body. Deepens without limit until the main thread stops it.
+static void helperSearch(Board b, SearchContext& ctx, int startDepth){
+  Move bestMove{};
+  int prevScore = 0;
+  for(int d = startDepth; d <= MAX_PLY && !stopped(ctx); ++d){
+    prevScore = aspirationSearch(b, ctx, d, prevScore, bestMove);
+  }
+}
+
+// Iterative deepening driver. Searches depth 1..limits.depth, each iteration
+// inside an aspiration window around the previous score, until a limit or the
+// stop flag ends it. onIteration, if set, is called after every completed
+// depth, with nodes summed over all threads.
+SearchResult search_root(Board& b, const SearchLimits& limits, const IterationCallback& onIteration){
+  SearchResult out{};
+  out.nodes = 0ULL;
+  TranspositionTable* tt = limits.tt ? limits.tt : &TT;
+  tt->newSearch();
+
+  MoveList rootMoves;
+  generateMoves(b, rootMoves);
+  if(rootMoves.empty()){
+    out.best = Move{};
+    out.score = b.inCheck(b.stm) ? -MATE_SCORE : 0;
+    return out;
+  }
 
-  // Build the principal variation at the root by walking best responses
-  out.pv.clear();
-  if(bestMove.from || bestMove.to){
-    out.pv.push_back(bestMove);
-    Board walk = b;
-    walk.makeMove(bestMove);
-    int d = depth - 1;
-    while(d > 0){
-      unsigned long long extraNodes = 0ULL;
-      Move next = chooseBestMove(walk, d, extraNodes);
-      out.nodes += extraNodes;
-      if(!(next.from || next.to)) break; // no more legal moves
-      out.pv.push_back(next);
-      walk.makeMove(next);
-      --d;
+  const auto start = std::chrono::steady_clock::now();
+  const TimeBudget budget = limits.infinite ? TimeBudget{} : allocateTime(limits.time, b.stm);
+  std::atomic<bool> searchStop{false};
+  std::atomic<bool>* stop = &searchStop;
+
+  // Start the helpers, each with its own board copy and context
+  const int helperCount = std::clamp(limits.threads, 1, MAX_THREADS) - 1;
+  std::vector<std::unique_ptr<SearchContext>> helperCtx;
+  std::vector<std::thread> helpers;
+  for(int i = 0; i < helperCount; ++i){
+    helperCtx.push_back(std::make_unique<SearchContext>());
+    helperCtx.back()->stop = stop;
+    helperCtx.back()->external = limits.stop;
+    helperCtx.back()->tt = tt;
+    helperCtx.back()->features = limits.features;
+    initStates(*helperCtx.back(), b, limits);
+    helpers.emplace_back(helperSearch, b, std::ref(*helperCtx.back()), 1 + (i & 1));
+  }
+  auto totalNodes = [&](const SearchContext& mainCtx){
+    unsigned long long n = mainCtx.nodes.load(std::memory_order_relaxed);
+    for(const auto& h : helperCtx) n += h->nodes.load(std::memory_order_relaxed);
+    return n;
+  };
+
+  auto ctx = std::make_unique<SearchContext>();
+  ctx->stop = stop;
+  ctx->external = limits.stop;
+  ctx->tt = tt;
+  ctx->isMain = true;
+  ctx->features = limits.features;
+  initStates(*ctx, b, limits);
+  ctx->start = start;
+  ctx->hardMs = budget.hard;
+  ctx->nodeLimit = limits.nodes;
+  const int depth = std::min(limits.depth, MAX_PLY);
+  Move bestMove{};
+  int prevScore = 0;
+  [[maybe_unused]] uint64_t mainNodesBefore = 0;
+  for(int d = 1; d <= depth; ++d){
+    pollStop(*ctx); // a stop may have come in before the search started
+    if(stopped(*ctx)) break;
+    int score = aspirationSearch(b, *ctx, d, prevScore, bestMove);
+    if(stopped(*ctx)) break; // incomplete, keep the previous iteration
+    prevScore = score;
+
+    out.best = bestMove;
+    out.score = score;
+    out.depth = d;
+    if constexpr(SEARCH_STATS){ // main thread only, helpers run their own depths
+      const uint64_t mainNodes = ctx->nodes.load(std::memory_order_relaxed);
+      out.stats.depthNodes.push_back(mainNodes - mainNodesBefore);
+      mainNodesBefore = mainNodes;
     }
+    out.nodes = totalNodes(*ctx);
+
+    // Principal variation collected during the search
+    out.pv.assign(ctx->pv[0], ctx->pv[0] + ctx->pvLength[0]);
+    if(out.pv.empty() || !(out.pv[0] == bestMove)) out.pv.assign(1, bestMove);
+    extendPvFromTT(*tt, b, out.pv, d);
+
+    if(onIteration) onIteration(out);
+
+    // The next iteration would likely not finish in time
+    if(budget.soft >= 0 && elapsedMs(*ctx) >= budget.soft) break;
+  }
+
+  stop->store(true, std::memory_order_relaxed);
+  for(std::thread& t : helpers) t.join();
+  out.nodes = totalNodes(*ctx);
+  if constexpr(SEARCH_STATS){
+    out.stats.add(ctx->stats);
+    for(const auto& h : helperCtx) out.stats.add(h->stats);
+    out.stats.nodes = out.nodes;
   }
 
+  // Stopped before depth 1 completed
+  if(out.best.isNone()){
+    out.best = rootMoves[0];
+    out.pv.assign(1, out.best);
+  }
   return out;
-}
\ No newline at end of file
+}
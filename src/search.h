@@ -1,5 +1,56 @@
 #pragma once
+#include <atomic>
+#include <functional>
 #include "board.h"
 #include "movegen.h"
-struct SearchResult { Move best; int score; unsigned long long nodes; std::vector<Move> pv;}; //pv = principal variation
-SearchResult search_root(Board& b, int depth);
\ No newline at end of file
+#include "timeman.h"
+#include "stats.h"
+
+class TranspositionTable;
+
+// Deepest ply the search can reach from the root
+constexpr int MAX_PLY = 128;
+
+// Mate score base. Being mated p plies from the root scores -(MATE_SCORE - p).
+constexpr int MATE_SCORE = 100000;
+// Scores beyond this magnitude are mate scores
+constexpr int MATE_BOUND = MATE_SCORE - 1024;
+
+constexpr bool isMateScore(int score){ return score > MATE_BOUND || score < -MATE_BOUND; }
+
+// Full moves to mate for a mate score: positive if the side to move mates,
+// negative if it is mated, as UCI "score mate" reports it
+constexpr int mateInMoves(int score){
+  return score > 0 ? (MATE_SCORE - score + 1) / 2 : -(MATE_SCORE + score) / 2;
+}
+
+struct SearchResult { Move best; int score; unsigned long long nodes; std::vector<Move> pv; int depth; SearchStats stats;}; //pv = principal variation, stats filled in BLITZ_STATS builds
+
+// Upper bound on search threads
+constexpr int MAX_THREADS = 256;
+
+// Selective search switches, all on by default. Turning one off gives the
+// baseline for an A/B comparison.
+struct SearchFeatures {
+  bool nullMove{true};  // null-move pruning
+  bool lmr{true};       // late-move reductions
+  bool futility{true};  // reverse and forward futility pruning near the leaves
+};
+
+// What a search may use. The search ends at the first limit reached.
+struct SearchLimits {
+  int depth{MAX_PLY};              // deepest iteration
+  int threads{1};                  // main thread plus threads-1 Lazy SMP helpers
+  unsigned long long nodes{0};     // main thread node budget, 0 for none
+  TimeLimits time;                 // clock parameters, all unset for no time limit
+  bool infinite{false};            // ignore the clock, run until depth or stop
+  SearchFeatures features;         // which pruning and reductions to apply
+  const std::atomic<bool>* stop{nullptr}; // optional flag another thread sets to end the search, only read
+  const StateStack* history{nullptr}; // optional game moves that led to the root, for repetitions
+  TranspositionTable* tt{nullptr}; // table to use, the global TT when null
+};
+
+// Called after each completed iteration with the result so far
+using IterationCallback = std::function<void(const SearchResult&)>;
+
+SearchResult search_root(Board& b, const SearchLimits& limits, const IterationCallback& onIteration = {});
@@ -0,0 +1,79 @@
+#include "stats.h"
+#include <cstdio>
+
+// File: stats.cpp
+// Purpose: Summing and formatting search statistics.
+// Notes:
+//  - Rates are percentages. The cutoff rate is over interior nodes that
+//    searched a move; the first-move rate is over the cutoffs. The quiescence
+//    share is over all nodes.
+//  - The effective branching factor is the ratio of the last two iterations'
+//    node counts, left out until there are two.
+
+void SearchStats::add(const SearchStats& o){
+  nodes += o.nodes;
+  qnodes += o.qnodes;
+  ttProbes += o.ttProbes;
+  ttHits += o.ttHits;
+  ttCollisions += o.ttCollisions;
+  searched += o.searched;
+  cutoffs += o.cutoffs;
+  firstCutoffs += o.firstCutoffs;
+  movegenNs += o.movegenNs;
+  evalNs += o.evalNs;
+}
+
+static double percent(uint64_t part, uint64_t whole){
+  return whole ? 100.0 * double(part) / double(whole) : 0.0;
+}
+
+static double branchingFactor(const SearchStats& s){
+  const size_t n = s.depthNodes.size();
+  if(n < 2 || s.depthNodes[n - 2] == 0) return 0.0;
+  return double(s.depthNodes[n - 1]) / double(s.depthNodes[n - 2]);
+}
+
+std::vector<std::string> statsLines(const SearchStats& s){
+  std::vector<std::string> lines;
+  char buf[256];
+  std::snprintf(buf, sizeof(buf), "tt probes %llu hits %llu (%.1f%%) misses %llu collisions %llu",
+                (unsigned long long)s.ttProbes, (unsigned long long)s.ttHits, percent(s.ttHits, s.ttProbes),
+                (unsigned long long)(s.ttProbes - s.ttHits), (unsigned long long)s.ttCollisions);
+  lines.emplace_back(buf);
+  std::snprintf(buf, sizeof(buf), "cutoffs %llu of %llu nodes (%.1f%%) first move %.1f%%",
+                (unsigned long long)s.cutoffs, (unsigned long long)s.searched, percent(s.cutoffs, s.searched),
+                percent(s.firstCutoffs, s.cutoffs));
+  lines.emplace_back(buf);
+  std::snprintf(buf, sizeof(buf), "nodes %llu qnodes %llu (%.1f%%) ebf %.2f",
+                (unsigned long long)s.nodes, (unsigned long long)s.qnodes, percent(s.qnodes, s.nodes),
+                branchingFactor(s));
+  lines.emplace_back(buf);
+
+  std::string perDepth = "nodes per depth";
+  for(uint64_t n : s.depthNodes){ perDepth += ' '; perDepth += std::to_string(n); }
+  lines.push_back(perDepth);
+
+  std::snprintf(buf, sizeof(buf), "time movegen %.1f ms eval %.1f ms",
+                double(s.movegenNs) / 1e6, double(s.evalNs) / 1e6);
+  lines.emplace_back(buf);
+  return lines;
+}
+
+std::string statsJson(const SearchStats& s){
+  char buf[512];
+  std::snprintf(buf, sizeof(buf),
+                "{\"nodes\":%llu,\"qnodes\":%llu,\"tt_probes\":%llu,\"tt_hits\":%llu,\"tt_collisions\":%llu,"
+                "\"searched\":%llu,\"cutoffs\":%llu,\"first_cutoffs\":%llu,\"ebf\":%.3f,"
+                "\"movegen_ms\":%.3f,\"eval_ms\":%.3f,\"depth_nodes\":[",
+                (unsigned long long)s.nodes, (unsigned long long)s.qnodes, (unsigned long long)s.ttProbes,
+                (unsigned long long)s.ttHits, (unsigned long long)s.ttCollisions, (unsigned long long)s.searched,
+                (unsigned long long)s.cutoffs, (unsigned long long)s.firstCutoffs, branchingFactor(s),
+                double(s.movegenNs) / 1e6, double(s.evalNs) / 1e6);
+  std::string out = buf;
+  for(size_t i = 0; i < s.depthNodes.size(); ++i){
+    if(i) out += ',';
+    out += std::to_string(s.depthNodes[i]);
+  }
+  out += "]}";
+  return out;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// File: stats.h
+// Purpose: Optional search statistics for tuning move ordering and pruning.
+// Notes:
+//  - Collected only in builds configured with BLITZ_STATS. Otherwise every
+//    counting site is an if constexpr on a false constant and compiles to
+//    nothing. SearchStats still exists so callers build either way.
+//  - Each search thread counts into its own SearchStats with plain adds.
+//    The totals are summed when the search ends.
+//  - Timers read steady_clock on entry and exit, tens of nanoseconds per
+//    call, so a stats build is slower. Compare ratios, not speeds.
+
+#ifdef BLITZ_STATS
+constexpr bool SEARCH_STATS = true;
+#else
+constexpr bool SEARCH_STATS = false;
+#endif
+
+struct SearchStats {
+  uint64_t nodes{0};          // every negamax and quiescence call
+  uint64_t qnodes{0};         // quiescence calls
+  uint64_t ttProbes{0};       // interior node probes
+  uint64_t ttHits{0};         // probes that found the position
+  uint64_t ttCollisions{0};   // stores that evicted another position's entry
+  uint64_t searched{0};       // interior nodes that searched at least one move
+  uint64_t cutoffs{0};        // of those, nodes that failed high
+  uint64_t firstCutoffs{0};   // of those, fail highs on the first move
+  uint64_t movegenNs{0};      // time in MovePicker::next, generation and ordering
+  uint64_t evalNs{0};         // time in static evaluation
+  std::vector<uint64_t> depthNodes; // main thread nodes of each completed iteration, depth 1 first
+
+  // Add another thread's counters. depthNodes is kept from the main thread.
+  void add(const SearchStats& o);
+};
+
+// Adds the time spent in its scope to a nanosecond counter, stats builds only
+class StatsTimer {
+public:
+  explicit StatsTimer(uint64_t& ns) : total(ns) {
+    if constexpr(SEARCH_STATS) start = std::chrono::steady_clock::now();
+  }
+  ~StatsTimer(){
+    if constexpr(SEARCH_STATS)
+      total += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+  }
+  StatsTimer(const StatsTimer&) = delete;
+  StatsTimer& operator=(const StatsTimer&) = delete;
+
+private:
+  uint64_t& total;
+  std::chrono::steady_clock::time_point start{};
+};
+
+// Human-readable summary, a few lines without trailing newlines. UCI sends
+// each as "info string <line>".
+std::vector<std::string> statsLines(const SearchStats& s);
+
+// The same figures as one JSON object
+std::string statsJson(const SearchStats& s);
@@ -0,0 +1,31 @@
+#include "timeman.h"
+#include <algorithm>
+
+// File: timeman.cpp
+// Purpose: Per-move time allocation.
+// Notes:
+//  - With a clock, the optimum is an even share of the remaining time over
+//    the expected moves left plus most of the increment. The search may stop
+//    after an iteration past half of it, and is cut off at three times it.
+//  - Neither limit ever exceeds the clock minus the move overhead.
+
+// Moves assumed left in sudden death games
+static const int DEFAULT_MOVES_TO_GO = 30;
+static const int MAX_MOVES_TO_GO = 50;
+
+TimeBudget allocateTime(const TimeLimits& t, Color us){
+  TimeBudget budget;
+  if(t.movetime > 0){
+    budget.soft = budget.hard = std::max<int64_t>(1, t.movetime - t.overhead);
+    return budget;
+  }
+  if(t.time[us] <= 0) return budget; // no clock, depth or node limits only
+
+  const int64_t avail = std::max<int64_t>(1, t.time[us] - t.overhead);
+  const int mtg = t.movestogo > 0 ? std::min(t.movestogo, MAX_MOVES_TO_GO) : DEFAULT_MOVES_TO_GO;
+  const int64_t optimum = std::min(avail / mtg + t.inc[us] * 3 / 4, avail * 8 / 10);
+
+  budget.hard = std::max<int64_t>(1, std::min(optimum * 3, avail * 9 / 10));
+  budget.soft = std::max<int64_t>(1, std::min(optimum / 2, budget.hard));
+  return budget;
+}
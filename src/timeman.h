@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include "board.h"
+
+// File: timeman.h
+// Purpose: Turn UCI clock parameters into a time budget for one move.
+// Notes:
+//  - soft is checked between iterations: no new iteration starts after it.
+//  - hard aborts the search mid-iteration.
+//  - Both are milliseconds from the start of the search, -1 for no limit.
+
+struct TimeLimits {
+  int64_t movetime{0};      // exact time per move, 0 if unset
+  int64_t time[2]{0, 0};    // remaining clock per color, 0 if unset
+  int64_t inc[2]{0, 0};     // increment per color
+  int movestogo{0};         // moves to the next time control, 0 for sudden death
+  int64_t overhead{30};     // reserved per move for communication lag
+};
+
+struct TimeBudget {
+  int64_t soft{-1};
+  int64_t hard{-1};
+};
+
+TimeBudget allocateTime(const TimeLimits& t, Color us);
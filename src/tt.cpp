@@ -1,2 +1,88 @@
 #include "tt.h"
-// stubs for future table logic
\ No newline at end of file
+#include <algorithm>
+
+// File: tt.cpp
+// Purpose: Transposition table storage, probing and replacement.
+// Notes:
+//  - Replacement inside a bucket: same key first, then the entry with the
+//    lowest depth, where entries from older searches count as shallower.
+//  - Slots are read and written with relaxed ordering. The key check is what
+//    makes a read consistent, not the memory order.
+
+TranspositionTable TT;
+
+static inline uint64_t pack(const TTEntry& e){ return std::bit_cast<uint64_t>(e); }
+static inline TTEntry unpack(uint64_t d){ return std::bit_cast<TTEntry>(d); }
+
+TranspositionTable::TranspositionTable(){ resize(TT_DEFAULT_MB); }
+
+void TranspositionTable::resize(size_t mb){
+  size_t bytes = std::max<size_t>(mb, 1) * 1024 * 1024;
+  size_t n = 1;
+  while(n * 2 * sizeof(TTBucket) <= bytes) n *= 2;
+  buckets = std::make_unique<TTBucket[]>(n);
+  count = n;
+  mask = n - 1;
+  generation = 0;
+}
+
+void TranspositionTable::clear(){
+  for(size_t i = 0; i < count; ++i){
+    for(TTSlot& s : buckets[i].slot){
+      s.keyXorData.store(0, std::memory_order_relaxed);
+      s.data.store(0, std::memory_order_relaxed);
+    }
+  }
+  generation = 0;
+}
+
+void TranspositionTable::newSearch(){
+  generation = uint8_t((generation + 1) & 63);
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& out) const{
+  const TTBucket& bk = bucketFor(key);
+  for(const TTSlot& s : bk.slot){
+    uint64_t d = s.data.load(std::memory_order_relaxed);
+    uint64_t k = s.keyXorData.load(std::memory_order_relaxed) ^ d;
+    if(k != key) continue;
+    TTEntry e = unpack(d);
+    if(e.bound() == BOUND_NONE) continue;
+    out = e;
+    return true;
+  }
+  return false;
+}
+
+bool TranspositionTable::store(uint64_t key, int depth, Bound bound, int score, Move move){
+  TTBucket& bk = bucketFor(key);
+
+  // Pick the slot to overwrite
+  TTSlot* slot = &bk.slot[0];
+  TTEntry old{};
+  bool sameKey = false;
+  int worst = 1 << 30;
+  bool evicted = true;
+  for(TTSlot& s : bk.slot){
+    uint64_t d = s.data.load(std::memory_order_relaxed);
+    uint64_t k = s.keyXorData.load(std::memory_order_relaxed) ^ d;
+    TTEntry e = unpack(d);
+    if(k == key || e.bound() == BOUND_NONE){ slot = &s; old = e; sameKey = (k == key); evicted = false; break; }
+    int age = (generation - e.gen()) & 63;
+    int value = e.depth - 4 * age;
+    if(value < worst){ worst = value; slot = &s; }
+  }
+
+  // Keep the old move if the new result has none for this position
+  if(sameKey && move.isNone()) move = old.move;
+
+  TTEntry e;
+  e.score = score;
+  e.move = move;
+  e.depth = int8_t(depth);
+  e.genBound = uint8_t((generation << 2) | bound);
+  const uint64_t d = pack(e);
+  slot->keyXorData.store(key ^ d, std::memory_order_relaxed);
+  slot->data.store(d, std::memory_order_relaxed);
+  return evicted;
+}
@@ -1 +1,80 @@
-int dummy_tt_placeholder = 0;
\ No newline at end of file
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "move.h"
+
+// File: tt.h
+// Purpose: Transposition table that caches search results by Zobrist key.
+// Notes:
+//  - The table holds a power-of-two number of buckets, so the bucket index
+//    is a mask of the low key bits.
+//  - Each bucket is one 64-byte cache line holding four 16-byte slots.
+//  - The table is shared by all search threads without locks. A slot stores
+//    the packed entry and the key xored with it. A slot torn by two threads
+//    writing at once no longer verifies against its key and reads as a miss.
+//  - Scores are stored as given. Callers adjust mate scores for ply.
+
+// Kind of score stored in an entry
+enum Bound : uint8_t {
+  BOUND_NONE  = 0,
+  BOUND_UPPER = 1, // fail low, score is an upper bound
+  BOUND_LOWER = 2, // fail high, score is a lower bound
+  BOUND_EXACT = 3  // PV node, score is exact
+};
+
+// Unpacked entry, exactly 64 bits so it packs into one slot word
+struct TTEntry {
+  int32_t score{0};   // search score
+  Move move{};        // best or refutation move, may be empty
+  int8_t depth{0};    // remaining depth the score was searched to
+  uint8_t genBound{0}; // bits 0-1: Bound, bits 2-7: search generation
+
+  Bound bound() const { return Bound(genBound & 3); }
+  uint8_t gen() const { return uint8_t(genBound >> 2); }
+};
+
+static_assert(sizeof(TTEntry) == 8, "TT entry must pack into 64 bits");
+
+// Stored form. Relaxed atomics compile to plain loads and stores.
+struct TTSlot {
+  std::atomic<uint64_t> keyXorData{0};
+  std::atomic<uint64_t> data{0};
+};
+
+constexpr int TT_BUCKET_SIZE = 4;
+
+struct alignas(64) TTBucket {
+  TTSlot slot[TT_BUCKET_SIZE];
+};
+
+static_assert(sizeof(TTBucket) == 64, "TT bucket must fill one cache line");
+
+class TranspositionTable {
+public:
+  TranspositionTable();
+
+  void resize(size_t mb);      // reallocate to the largest power of two buckets that fit in mb
+  void clear();                // wipe all entries, call on a new game
+  void newSearch();            // advance the generation so old entries are replaced first
+  bool probe(uint64_t key, TTEntry& out) const; // true and fills out if key is present
+  // Returns true if the entry overwritten held another position
+  bool store(uint64_t key, int depth, Bound bound, int score, Move move);
+  size_t sizeMB() const { return count * sizeof(TTBucket) / (1024 * 1024); }
+
+private:
+  TTBucket& bucketFor(uint64_t key) { return buckets[key & mask]; }
+  const TTBucket& bucketFor(uint64_t key) const { return buckets[key & mask]; }
+
+  std::unique_ptr<TTBucket[]> buckets;
+  size_t count{0};
+  uint64_t mask{0};
+  uint8_t generation{0};
+};
+
+constexpr size_t TT_DEFAULT_MB = 16;
+
+// Table shared by the search
+extern TranspositionTable TT;
@@ -1,52 +1,66 @@
 #include "board.h"
 #include "movegen.h"
 #include "search.h"
+#include "tt.h"
+#include "perfthash.h"
+#include "bench.h"
+#include "nnue.h"
+#include "analyze.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include <cctype>
+#include <cstring>
 #include <cstdlib>
 
 // File: uci.cpp
 // Purpose: Command-line front-end for blitz engine.
+// With no arguments, or with "uci", runs the UCI protocol on stdin/stdout.
 // Supports commands:
-//   blitz perft N        -> run perft to depth N
-//   blitz divide N       -> per-move perft breakdown
-//   blitz search depth N -> search to depth N, print bestmove and PV
+//   blitz perft N [--threads T] [--hash MB] [--fen FEN]  -> run perft to depth N
+//   blitz divide N [--threads T] [--hash MB] [--fen FEN] -> per-move perft breakdown
+//   blitz search depth N [hash MB] [threads T] [fen FEN] -> search to depth N, print bestmove and PV
+//     [evalfile PATH] searches with a network instead of the hand-crafted eval
+//     [nullmove|lmr|futility on|off] switches one selective search feature
+//   blitz bench [depth] [threads] [hash] -> search the built-in suite, print nodes and nps
+//   blitz analyze [--input FILE] [--depth N] [--workers W] [--hash MB] -> search each FEN or EPD
+//     line of FILE (stdin by default) and print one JSON result per line
 //   blitz play           -> interactive play mode
 
-// Convert internal Move to UCI string (e.g. "e2e4", "e7e8q")
-static std::string move_to_uci(const Move& m) {
-  std::string s;
-  s.push_back(char('a' + (m.from % 8)));
-  s.push_back(char('1' + (m.from / 8)));
-  s.push_back(char('a' + (m.to   % 8)));
-  s.push_back(char('1' + (m.to   / 8)));
-  if (m.promo) {
-    char pc = 'q';
-    if (m.promo == WR || m.promo == BR) pc = 'r';
-    else if (m.promo == WB || m.promo == BB) pc = 'b';
-    else if (m.promo == WN || m.promo == BN) pc = 'n';
-    s.push_back(pc);
-  }
-  return s;
+// Output lines can come from the search thread and the input thread at once
+static std::mutex outputMutex;
+
+// Write one complete line to stdout and flush it
+static void send(const std::string& line) {
+  std::lock_guard<std::mutex> lock(outputMutex);
+  std::cout << line << "\n" << std::flush;
 }
 
 // Print usage help
 static void print_usage() {
-  std::cout << "usage: blitz perft N\n";
-  std::cout << "       blitz divide N\n";
-  std::cout << "       blitz search depth N\n";
+  std::cout << "usage: blitz [uci]\n";
+  std::cout << "       blitz perft N [--threads T] [--hash MB] [--fen FEN]\n";
+  std::cout << "       blitz divide N [--threads T] [--hash MB] [--fen FEN]\n";
+  std::cout << "       blitz search depth N [hash MB] [threads T] [fen FEN] [evalfile PATH] [nullmove|lmr|futility on|off]\n";
+  std::cout << "       blitz bench [depth] [threads] [hash]\n";
+  std::cout << "       blitz analyze [--input FILE] [--depth N] [--workers W] [--hash MB]\n";
   std::cout << "       blitz play\n";
 }
 
-// Compare two moves by core fields
+// Compare a typed move with a generated one by from, to and promotion piece.
+// Typed moves carry no capture, castle or en passant kind.
 static bool same_move(const Move& a, const Move& b) {
-  return a.from == b.from && a.to == b.to && a.promo == b.promo;
+  return a.from() == b.from() && a.to() == b.to() && a.isPromo() == b.isPromo() &&
+         (!a.isPromo() || a.promoType() == b.promoType());
 }
 
-// Parse a UCI string like "e2e4" or "e7e8q" into a Move with promo resolved for side to move
-static bool parse_uci_move(const Board& b, const std::string& s, Move& out){
+// Parse a UCI string like "e2e4" or "e7e8q" into a Move carrying only from, to and promotion
+static bool parse_uci_move(const std::string& s, Move& out){
   if(s.size() < 4) return false;
   int ffile = s[0] - 'a';
   int frank = s[1] - '1';
@@ -55,16 +69,14 @@ static bool parse_uci_move(const Board& b, const std::string& s, Move& out){
   if(ffile < 0 || ffile > 7 || tfile < 0 || tfile > 7 || frank < 0 || frank > 7 || trank < 0 || trank > 7) return false;
   int from = frank * 8 + ffile;
   int to   = trank * 8 + tfile;
-  int promo = 0;
+  int kind = MK_QUIET;
   if(s.size() >= 5){
-    char pc = std::tolower(s[4]);
-    if(b.stm == WHITE){
-      if(pc == 'q') promo = WQ; else if(pc == 'r') promo = WR; else if(pc == 'b') promo = WB; else if(pc == 'n') promo = WN; else return false;
-    } else {
-      if(pc == 'q') promo = BQ; else if(pc == 'r') promo = BR; else if(pc == 'b') promo = BB; else if(pc == 'n') promo = BN; else return false;
-    }
+    static const char promoChars[] = "nbrq"; // indexed by PromoType
+    const char* pc = std::strchr(promoChars, std::tolower(s[4]));
+    if(!pc || !*pc) return false;
+    kind = MK_PROMO | int(pc - promoChars);
   }
-  out = Move{(uint16_t)from,(uint16_t)to,(uint8_t)promo,(uint8_t)0};
+  out = Move(from, to, kind);
   return true;
 }
 
@@ -76,69 +88,341 @@ static bool legal_in_pos(const Board& b, const Move& m) {
   return false;
 }
 
-// Find the fully-encoded legal move (with flags) that matches from,to,promo
+// Find the fully-encoded legal move (with kind) that matches from,to,promo
 static bool find_legal_matching_move(const Board& b, const Move& want, Move& matched) {
   std::vector<Move> mv;
   generateMoves(b, mv);
   for (const auto& x : mv) {
-    if (x.from == want.from && x.to == want.to && x.promo == want.promo) {
-      matched = x; // x carries correct flags (e.g., MF_CASTLE, MF_ENPASSANT)
+    if (same_move(x, want)) {
+      matched = x; // x carries the full kind (castle, en passant, capture)
       return true;
     }
   }
   return false;
 }
 
+// UCI score field, "cp N" or "mate N" with N in moves, negative when being mated
+static std::string score_to_uci(int score) {
+  if (isMateScore(score)) return "mate " + std::to_string(mateInMoves(score));
+  return "cp " + std::to_string(score);
+}
+
+// Print one "info depth ..." line for a completed iteration
+static void print_info(const SearchResult& res, std::chrono::steady_clock::time_point start) {
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  unsigned long long nps = ms > 0 ? res.nodes * 1000ULL / (unsigned long long)ms : 0ULL;
+  std::ostringstream line;
+  line << "info depth " << res.depth << " score " << score_to_uci(res.score)
+       << " nodes " << res.nodes << " nps " << nps << " time " << ms << " pv";
+  for (const auto& m : res.pv) line << " " << moveToUci(m);
+  send(line.str());
+}
+
+// Send the search statistics as info strings, in BLITZ_STATS builds only
+static void print_stats(const SearchResult& res) {
+  if constexpr (!SEARCH_STATS) return;
+  for (const std::string& l : statsLines(res.stats)) {
+    std::string line = "info string ";
+    line += l;
+    send(line);
+  }
+}
+
+// Search with per-iteration info lines, then print bestmove and PV
+static SearchResult run_search(Board& b, const SearchLimits& limits) {
+  auto start = std::chrono::steady_clock::now();
+  SearchResult res = search_root(b, limits, [&](const SearchResult& r) { print_info(r, start); });
+  print_stats(res);
+  std::cout << "bestmove " << moveToUci(res.best);
+  if (!res.pv.empty()) {
+    std::cout << " pv";
+    for (const auto& m : res.pv) std::cout << " " << moveToUci(m);
+  }
+  std::cout << "\n";
+  return res;
+}
+
+// UCI session state. The search runs on its own thread so "stop" and
+// "isready" are answered while it thinks.
+struct UciSession {
+  Board board;
+  StateStack history; // moves from the "position" command, for repetitions
+  int threads{1};
+  int64_t moveOverhead{30};
+  SearchFeatures features;
+  std::thread searcher;
+  std::atomic<bool> stop{false};
+
+  // Stop a running search and wait for its bestmove
+  void finishSearch() {
+    if (searcher.joinable()) {
+      stop.store(true);
+      searcher.join();
+    }
+  }
+};
+
+// "position startpos|fen <fen> [moves m1 m2 ...]"
+static void uci_position(UciSession& s, std::istringstream& in) {
+  std::string token, fen;
+  in >> token;
+  if (token == "startpos") {
+    fen = "startpos";
+    in >> token;
+  } else if (token == "fen") {
+    while (in >> token && token != "moves") fen += (fen.empty() ? "" : " ") + token;
+  } else {
+    return;
+  }
+  Board b;
+  if (!b.loadFEN(fen)) {
+    send("info string invalid FEN " + fen);
+    return;
+  }
+  s.history.clear();
+  if (token == "moves") {
+    while (in >> token) {
+      Move typed{}, flagged{};
+      if (!parse_uci_move(token, typed) || !find_legal_matching_move(b, typed, flagged)) {
+        send("info string illegal move " + token);
+        break;
+      }
+      if (s.history.full()) {
+        send("info string too many moves, stopped at " + token);
+        break;
+      }
+      b.makeMove(flagged, s.history);
+    }
+  }
+  s.board = b;
+}
+
+// Load a network for the search, or with an empty path go back to the
+// hand-crafted eval
+static void load_eval_file(const std::string& path) {
+  if (path.empty() || path == "<empty>") {
+    NNUE.unload();
+    send("info string using the hand-crafted eval");
+    return;
+  }
+  std::string error;
+  if (NNUE.load(path, error)) send("info string loaded network " + path);
+  else send("info string cannot load network: " + error);
+}
+
+// "setoption name <name> value <value>"
+static void uci_setoption(UciSession& s, std::istringstream& in) {
+  std::string token, name, value;
+  in >> token; // "name"
+  while (in >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+  std::getline(in >> std::ws, value); // the rest of the line, paths may hold spaces
+  for (char& c : name) c = char(std::tolower(c));
+  if (name == "hash") TT.resize((size_t)std::max(1, std::atoi(value.c_str())));
+  else if (name == "threads") s.threads = std::clamp(std::atoi(value.c_str()), 1, MAX_THREADS);
+  else if (name == "moveoverhead") s.moveOverhead = std::max(0, std::atoi(value.c_str()));
+  else if (name == "nullmove") s.features.nullMove = value == "true";
+  else if (name == "lmr") s.features.lmr = value == "true";
+  else if (name == "futility") s.features.futility = value == "true";
+  else if (name == "evalfile") load_eval_file(value);
+  else if (name == "clear hash") TT.clear();
+  else send("info string unknown option " + name);
+}
+
+// "go [depth N] [nodes N] [movetime MS] [wtime MS btime MS winc MS binc MS movestogo N] [infinite]"
+static void uci_go(UciSession& s, std::istringstream& in) {
+  SearchLimits limits;
+  limits.threads = s.threads;
+  limits.time.overhead = s.moveOverhead;
+  limits.features = s.features;
+  // Unknown tokens, and their arguments, are skipped one at a time, so
+  // "searchmoves e2e4 movetime 200" or "ponder wtime ..." keep their limits
+  static const char* const NUMERIC[] = { "depth", "nodes", "movetime", "wtime", "btime", "winc", "binc", "movestogo" };
+  std::string token;
+  while (in >> token) {
+    if (token == "infinite") { limits.infinite = true; continue; }
+    if (std::find(std::begin(NUMERIC), std::end(NUMERIC), token) == std::end(NUMERIC)) continue;
+    long long v = 0;
+    if (!(in >> v)) { in.clear(); continue; } // missing number, read the next token as a keyword
+    if (token == "depth") limits.depth = std::clamp((int)v, 1, MAX_PLY);
+    else if (token == "nodes") limits.nodes = (unsigned long long)std::max(1LL, v);
+    else if (token == "movetime") limits.time.movetime = v;
+    else if (token == "wtime") limits.time.time[WHITE] = v;
+    else if (token == "btime") limits.time.time[BLACK] = v;
+    else if (token == "winc") limits.time.inc[WHITE] = v;
+    else if (token == "binc") limits.time.inc[BLACK] = v;
+    else if (token == "movestogo") limits.time.movestogo = (int)v;
+  }
+
+  s.finishSearch();
+  s.stop.store(false);
+  limits.stop = &s.stop;
+  s.searcher = std::thread([&s, limits, b = s.board, history = s.history]() mutable {
+    limits.history = &history;
+    auto start = std::chrono::steady_clock::now();
+    SearchResult res = search_root(b, limits, [&](const SearchResult& r) { print_info(r, start); });
+    print_stats(res);
+    // While infinite, bestmove may only be sent after "stop"
+    while (limits.infinite && !s.stop.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    send("bestmove " + (res.best.isNone() ? std::string("0000") : moveToUci(res.best)));
+  });
+}
+
+// Standard UCI loop on stdin/stdout
+static void uci_loop() {
+  UciSession s;
+  s.board.loadFEN("startpos");
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    std::istringstream in(line);
+    std::string cmd;
+    in >> cmd;
+    if (cmd == "uci") {
+      send("id name blitz");
+      send("id author blitz developers");
+      send("option name Hash type spin default " + std::to_string(TT_DEFAULT_MB) + " min 1 max 65536");
+      send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+      send("option name MoveOverhead type spin default 30 min 0 max 5000");
+      send("option name NullMove type check default true");
+      send("option name LMR type check default true");
+      send("option name Futility type check default true");
+      send("option name EvalFile type string default <empty>");
+      send("option name Clear Hash type button");
+      send("uciok");
+    } else if (cmd == "isready") {
+      send("readyok");
+    } else if (cmd == "ucinewgame") {
+      s.finishSearch();
+      TT.clear();
+    } else if (cmd == "position") {
+      s.finishSearch();
+      uci_position(s, in);
+    } else if (cmd == "setoption") {
+      s.finishSearch();
+      uci_setoption(s, in);
+    } else if (cmd == "go") {
+      uci_go(s, in);
+    } else if (cmd == "stop") {
+      s.finishSearch();
+    } else if (cmd == "quit") {
+      break;
+    } else if (cmd == "d") {
+      send(s.board.toFEN());
+    } else if (!cmd.empty()) {
+      send("info string unknown command " + cmd);
+    }
+  }
+  s.finishSearch();
+}
+
 // Print a tiny prompt showing side to move and depth
 static void print_prompt(const Board& b, int depth){
   std::cout << ((b.stm == WHITE) ? "white" : "black") << " to move | depth " << depth << "\n> " << std::flush;
 }
 
 int main(int argc, char* argv[]) {
+  if (argc == 1 || (argc == 2 && std::string(argv[1]) == "uci")) {
+    uci_loop();
+    return 0;
+  }
+
   Board b;
   b.loadFEN("startpos");
 
-  // perft N
-  if (argc == 3 && std::string(argv[1]) == "perft") {
+  // perft N [--threads T] [--hash MB], divide N [--threads T] [--hash MB]
+  if (argc >= 3 && argc % 2 == 1 && (std::string(argv[1]) == "perft" || std::string(argv[1]) == "divide")) {
     int depth = std::stoi(argv[2]);
-    unsigned long long nodes = perft(b, depth);
+    int threads = 1;
+    PerftHash cache;
+    for (int i = 3; i + 1 < argc; i += 2) {
+      std::string opt = argv[i];
+      if (opt == "--threads") threads = std::clamp(std::stoi(argv[i + 1]), 1, MAX_THREADS);
+      else if (opt == "--hash") cache.resize((size_t)std::max(0, std::stoi(argv[i + 1])));
+      else if (opt == "--fen") { if (!b.loadFEN(argv[i + 1])) { std::cout << "invalid FEN\n"; return 1; } }
+      else { print_usage(); return 1; }
+    }
+    PerftHash* cachePtr = cache.enabled() ? &cache : nullptr;
+    if (std::string(argv[1]) == "divide") {
+      perftDivide(b, depth, threads, cachePtr);
+      return 0;
+    }
+    auto start = std::chrono::steady_clock::now();
+    unsigned long long nodes = perft(b, depth, threads, cachePtr);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
     std::cout << "Perft(" << depth << ") = " << nodes << "\n";
+    std::cout << "time " << ms << " ms, " << (ms > 0 ? nodes * 1000ULL / (unsigned long long)ms : 0ULL) << " nps\n";
+    if (cachePtr) {
+      double rate = cache.probes() ? 100.0 * double(cache.hits()) / double(cache.probes()) : 0.0;
+      std::cout << "hash " << cache.sizeMB() << " MB, probes " << cache.probes() << ", hits " << cache.hits()
+                << " (" << rate << "%)\n";
+    }
     return 0;
   }
 
-  // divide N
-  if (argc == 3 && std::string(argv[1]) == "divide") {
-    int depth = std::stoi(argv[2]);
-    perftDivide(b, depth);
+  // search depth N [hash MB] [threads T] [fen FEN] [evalfile PATH] [nullmove|lmr|futility on|off]
+  if (argc >= 4 && argc % 2 == 0 && std::string(argv[1]) == "search" && std::string(argv[2]) == "depth") {
+    SearchLimits limits;
+    limits.depth = std::stoi(argv[3]);
+    for (int i = 4; i + 1 < argc; i += 2) {
+      std::string opt = argv[i];
+      if (opt == "fen") {
+        if (!b.loadFEN(argv[i + 1])) { std::cout << "invalid FEN\n"; return 1; }
+        continue;
+      }
+      if (opt == "evalfile") {
+        std::string error;
+        if (!NNUE.load(argv[i + 1], error)) { std::cout << "cannot load network: " << error << "\n"; return 1; }
+        continue;
+      }
+      if (opt == "nullmove" || opt == "lmr" || opt == "futility") {
+        bool on = std::string(argv[i + 1]) != "off";
+        if (opt == "nullmove") limits.features.nullMove = on;
+        else if (opt == "lmr") limits.features.lmr = on;
+        else limits.features.futility = on;
+        continue;
+      }
+      int value = std::max(1, std::stoi(argv[i + 1]));
+      if (opt == "hash") TT.resize((size_t)value);
+      else if (opt == "threads") limits.threads = std::min(value, MAX_THREADS);
+      else { print_usage(); return 1; }
+    }
+    run_search(b, limits);
     return 0;
   }
 
-  // search depth N
-  if (argc == 4 && std::string(argv[1]) == "search" && std::string(argv[2]) == "depth") {
-    int depth = std::stoi(argv[3]);
-    SearchResult res = search_root(b, depth);
-
-    // Info line for UCI
-    std::cout << "info score cp " << res.score << " nodes " << res.nodes << "\n";
+  // bench [depth] [threads] [hash]
+  if (argc >= 2 && argc <= 5 && std::string(argv[1]) == "bench") {
+    int depth = argc > 2 ? std::clamp(std::stoi(argv[2]), 1, MAX_PLY) : BENCH_DEFAULT_DEPTH;
+    int threads = argc > 3 ? std::clamp(std::stoi(argv[3]), 1, MAX_THREADS) : 1;
+    size_t hash = argc > 4 ? (size_t)std::max(1, std::stoi(argv[4])) : BENCH_DEFAULT_HASH_MB;
+    bench(depth, threads, hash);
+    return 0;
+  }
 
-    // Best move with principal variation
-    std::cout << "bestmove " << move_to_uci(res.best);
-    if (!res.pv.empty()) {
-      std::cout << " pv";
-      for (const auto& m : res.pv) {
-        std::cout << " " << move_to_uci(m);
-      }
+  // analyze [--input FILE] [--depth N] [--workers W] [--hash MB]
+  if (argc >= 2 && argc % 2 == 0 && std::string(argv[1]) == "analyze") {
+    AnalyzeOptions opts;
+    opts.workers = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 2; i + 1 < argc; i += 2) {
+      std::string opt = argv[i];
+      if (opt == "--input") opts.input = argv[i + 1];
+      else if (opt == "--depth") opts.depth = std::clamp(std::stoi(argv[i + 1]), 1, MAX_PLY);
+      else if (opt == "--workers") opts.workers = std::clamp(std::stoi(argv[i + 1]), 1, MAX_THREADS);
+      else if (opt == "--hash") opts.hashMB = (size_t)std::max(1, std::stoi(argv[i + 1]));
+      else { print_usage(); return 1; }
     }
-    std::cout << "\n";
-    return 0;
+    return analyze(opts) ? 0 : 1;
   }
 
   // play (interactive)
   if (argc == 2 && std::string(argv[1]) == "play") {
-    int depth = 4; // default search depth
+    SearchLimits limits;
+    limits.depth = 4; // default search depth
+    int& depth = limits.depth;
     std::vector<Move> played; // moves we applied, to support undo
+    StateStack history;       // their undo records, also seen by the search
+    limits.history = &history;
 
-    std::cout << "blitz interactive. Commands: move in UCI (e2e4), go, depth N, undo, reset, help, quit\n";
+    std::cout << "blitz interactive. Commands: move in UCI (e2e4), go, depth N, hash MB, threads N, fen FEN, d, undo, reset, help, quit\n";
     print_prompt(b, depth);
     std::string line;
     while (std::getline(std::cin, line)) {
@@ -148,7 +432,7 @@ int main(int argc, char* argv[]) {
 
       if (line == "quit" || line == "exit") break;
       if (line == "help") {
-        std::cout << "Commands: UCI move like e2e4, go, depth N, undo, reset, quit\n";
+        std::cout << "Commands: UCI move like e2e4, go, depth N, hash MB, threads N, fen FEN, d, undo, reset, quit\n";
         print_prompt(b, depth);
         continue;
       }
@@ -159,9 +443,40 @@ int main(int argc, char* argv[]) {
         print_prompt(b, depth);
         continue;
       }
+      if (line.rfind("hash ", 0) == 0) {
+        int mb = std::max(1, std::atoi(line.c_str()+5));
+        TT.resize((size_t)mb);
+        std::cout << "hash set to " << TT.sizeMB() << " MB\n";
+        print_prompt(b, depth);
+        continue;
+      }
+      if (line.rfind("threads ", 0) == 0) {
+        limits.threads = std::clamp(std::atoi(line.c_str()+8), 1, MAX_THREADS);
+        std::cout << "threads set to " << limits.threads << "\n";
+        print_prompt(b, depth);
+        continue;
+      }
+      if (line.rfind("fen ", 0) == 0) {
+        if (b.loadFEN(line.substr(4))) {
+          played.clear();
+          history.clear();
+          std::cout << "position set\n";
+        } else {
+          std::cout << "invalid FEN\n";
+        }
+        print_prompt(b, depth);
+        continue;
+      }
+      if (line == "d") {
+        std::cout << b.toFEN() << "\n";
+        print_prompt(b, depth);
+        continue;
+      }
       if (line == "reset") {
         b.loadFEN("startpos");
         played.clear();
+        history.clear();
+        TT.clear();
         std::cout << "reset to startpos\n";
         print_prompt(b, depth);
         continue;
@@ -170,7 +485,7 @@ int main(int argc, char* argv[]) {
         if (!played.empty()) {
           Move last = played.back();
           played.pop_back();
-          b.unmakeMove(last);
+          b.unmakeMove(last, history);
           std::cout << "undone\n";
         } else {
           std::cout << "nothing to undo\n";
@@ -179,22 +494,21 @@ int main(int argc, char* argv[]) {
         continue;
       }
       if (line == "go") {
-        SearchResult res = search_root(b, depth);
-        std::cout << "info score cp " << res.score << " nodes " << res.nodes << "\n";
-        std::cout << "bestmove " << move_to_uci(res.best);
-        if (!res.pv.empty()) { std::cout << " pv"; for (const auto& m : res.pv) std::cout << " " << move_to_uci(m); }
-        std::cout << "\n";
-        if (res.best.from || res.best.to) { b.makeMove(res.best); played.push_back(res.best); }
+        SearchResult res = run_search(b, limits);
+        if (!res.best.isNone() && !history.full()) { b.makeMove(res.best, history); played.push_back(res.best); }
         print_prompt(b, depth);
         continue;
       }
 
       // Try to parse a user move in UCI
       Move typed{};
-      if (parse_uci_move(b, line, typed)) {
+      if (parse_uci_move(line, typed)) {
         Move flagged{};
-        if (find_legal_matching_move(b, typed, flagged)) {
-          b.makeMove(flagged);           // use flagged move so rook/pawn capture is handled
+        if (history.full()) {
+          std::cout << "move limit reached\n";
+          print_prompt(b, depth);
+        } else if (find_legal_matching_move(b, typed, flagged)) {
+          b.makeMove(flagged, history);  // use flagged move so rook/pawn capture is handled
           played.push_back(flagged);
           print_prompt(b, depth);
         } else {
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+
+// File: zobrist.h
+// Purpose: Zobrist random keys used to hash positions.
+// Notes:
+//  - Keys are generated at compile time from a fixed seed, so every build
+//    and every run hashes the same position to the same key.
+//  - piece[p][sq] is indexed by Piece and square.
+//  - castle[] is indexed by the 4-bit castleRights value.
+//  - epFile[] is xored in only while an en passant square is set.
+//  - side is xored in when Black is to move.
+
+struct ZobristKeys {
+  uint64_t piece[12][64]{};
+  uint64_t castle[16]{};
+  uint64_t epFile[8]{};
+  uint64_t side{0};
+};
+
+// SplitMix64 step, good enough spread for hashing keys
+constexpr uint64_t splitmix64(uint64_t& state){
+  uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys(){
+  ZobristKeys z{};
+  uint64_t seed = 0x1F2E3D4C5B6A7988ULL;
+  for(int p = 0; p < 12; ++p)
+    for(int sq = 0; sq < 64; ++sq) z.piece[p][sq] = splitmix64(seed);
+  for(int i = 0; i < 16; ++i) z.castle[i] = splitmix64(seed);
+  for(int f = 0; f < 8; ++f) z.epFile[f] = splitmix64(seed);
+  z.side = splitmix64(seed);
+  return z;
+}
+
+inline constexpr ZobristKeys ZOBRIST = makeZobristKeys();
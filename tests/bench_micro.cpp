@@ -0,0 +1,223 @@
+#include "board.h"
+#include "movegen.h"
+#include "eval.h"
+#include "bench.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// File: bench_micro.cpp
+// Purpose: Microbenchmarks for the hot board primitives, built as
+// blitz_bench_micro. Not a test, so not registered with CTest.
+// Usage: blitz_bench_micro [rounds] [--counters]
+// Notes:
+//  - Every primitive loops over the bench suite positions 'rounds' times.
+//    One op is one call, a makeMove plus unmakeMove pair, or a Board copy
+//    plus makeMove.
+//  - Results feed a volatile sink so the calls cannot be optimized away.
+//  - --counters adds cycles, instructions and branch misses per op from
+//    perf_event_open on Linux. Where perf events are unavailable, e.g.
+//    perf_event_paranoid too high or inside a container, the columns are
+//    left out.
+
+static volatile uint64_t sink;
+
+// Hardware counters for the calling thread, user space only
+class PerfCounters {
+public:
+  enum { CYCLES, INSTRUCTIONS, BRANCH_MISSES, COUNT };
+
+  bool open(){
+#ifdef __linux__
+    const uint64_t configs[COUNT] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for(int i = 0; i < COUNT; ++i){
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[i];
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fd[i] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+      if(fd[i] < 0){ close(); return false; }
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void close(){
+#ifdef __linux__
+    for(int& f : fd){ if(f >= 0) ::close(f); f = -1; }
+#endif
+  }
+
+  void start(){
+#ifdef __linux__
+    for(int f : fd){ ioctl(f, PERF_EVENT_IOC_RESET, 0); ioctl(f, PERF_EVENT_IOC_ENABLE, 0); }
+#endif
+  }
+
+  void stop(uint64_t out[COUNT]){
+    for(int i = 0; i < COUNT; ++i){
+      out[i] = 0;
+#ifdef __linux__
+      ioctl(fd[i], PERF_EVENT_IOC_DISABLE, 0);
+      if(read(fd[i], &out[i], sizeof(out[i])) != (ssize_t)sizeof(out[i])) out[i] = 0;
+#endif
+    }
+  }
+
+  ~PerfCounters(){ close(); }
+
+private:
+  int fd[COUNT]{-1, -1, -1};
+};
+
+static PerfCounters counters;
+static bool useCounters = false;
+
+// Time fn, which performs and returns some number of ops, and print a row
+template<typename Fn>
+static void measure(const char* name, Fn fn){
+  uint64_t hw[PerfCounters::COUNT] = {};
+  if(useCounters) counters.start();
+  auto start = std::chrono::steady_clock::now();
+  uint64_t ops = fn();
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  if(useCounters) counters.stop(hw);
+
+  const double perOp = ops ? ns / double(ops) : 0.0;
+  std::printf("%-16s %12llu ops %9.2f ns/op %12.0f ops/s", name, (unsigned long long)ops, perOp,
+              perOp > 0 ? 1e9 / perOp : 0.0);
+  if(useCounters && ops){
+    std::printf(" %8.1f cyc/op %8.1f ins/op %6.3f brmiss/op", double(hw[PerfCounters::CYCLES]) / double(ops),
+                double(hw[PerfCounters::INSTRUCTIONS]) / double(ops),
+                double(hw[PerfCounters::BRANCH_MISSES]) / double(ops));
+  }
+  std::printf("\n");
+}
+
+int main(int argc, char* argv[]){
+  int rounds = 2000;
+  for(int i = 1; i < argc; ++i){
+    if(std::strcmp(argv[i], "--counters") == 0) useCounters = true;
+    else rounds = std::max(1, std::atoi(argv[i]));
+  }
+  if(useCounters && !counters.open()){
+    std::printf("hardware counters unavailable, timing only\n");
+    useCounters = false;
+  }
+
+  // Corpus: every suite position with its legal moves
+  std::vector<Board> boards;
+  std::vector<MoveList> moves;
+  for(int i = 0; i < BENCH_FEN_COUNT; ++i){
+    Board b;
+    if(!b.loadFEN(BENCH_FENS[i])) continue;
+    MoveList ml;
+    generateMoves(b, ml);
+    boards.push_back(b);
+    moves.push_back(ml);
+  }
+  std::printf("%zu positions, %d rounds\n", boards.size(), rounds);
+
+  measure("generateMoves", [&]{
+    uint64_t ops = 0, acc = 0;
+    MoveList ml;
+    for(int r = 0; r < rounds; ++r)
+      for(const Board& b : boards){ generateMoves(b, ml); acc += uint64_t(ml.size()); ++ops; }
+    sink = acc;
+    return ops;
+  });
+
+  measure("captures only", [&]{
+    uint64_t ops = 0, acc = 0;
+    MoveList ml;
+    for(int r = 0; r < rounds; ++r)
+      for(const Board& b : boards){ generateMoves(b, ml, GEN_CAPTURES); acc += uint64_t(ml.size()); ++ops; }
+    sink = acc;
+    return ops;
+  });
+
+  measure("countMoves", [&]{
+    uint64_t ops = 0, acc = 0;
+    for(int r = 0; r < rounds; ++r)
+      for(const Board& b : boards){ acc += uint64_t(countMoves(b)); ++ops; }
+    sink = acc;
+    return ops;
+  });
+
+  measure("make+unmake", [&]{
+    uint64_t ops = 0, acc = 0;
+    for(int r = 0; r < rounds; ++r){
+      for(size_t i = 0; i < boards.size(); ++i){
+        Board& b = boards[i];
+        State st;
+        for(const Move& m : moves[i]){ b.makeMove(m, st); acc += b.key; b.unmakeMove(m, st); ++ops; }
+      }
+    }
+    sink = acc;
+    return ops;
+  });
+
+  measure("copy+make", [&]{
+    uint64_t ops = 0, acc = 0;
+    for(int r = 0; r < rounds; ++r){
+      for(size_t i = 0; i < boards.size(); ++i){
+        State st;
+        for(const Move& m : moves[i]){ Board c = boards[i]; c.makeMove(m, st); acc += c.key; ++ops; }
+      }
+    }
+    sink = acc;
+    return ops;
+  });
+
+  measure("inCheck", [&]{
+    uint64_t ops = 0, acc = 0;
+    for(int r = 0; r < rounds; ++r)
+      for(const Board& b : boards){ acc += b.inCheck(b.stm); ++ops; }
+    sink = acc;
+    return ops;
+  });
+
+  measure("eval", [&]{
+    uint64_t ops = 0, acc = 0;
+    for(int r = 0; r < rounds; ++r)
+      for(const Board& b : boards){ acc += uint64_t(eval(b)); ++ops; }
+    sink = acc;
+    return ops;
+  });
+
+  measure("see", [&]{
+    uint64_t ops = 0, acc = 0;
+    for(int r = 0; r < rounds; ++r){
+      for(size_t i = 0; i < boards.size(); ++i){
+        for(const Move& m : moves[i]){
+          if(!m.isCapture()) continue;
+          acc += uint64_t(see(boards[i], m));
+          ++ops;
+        }
+      }
+    }
+    sink = acc;
+    return ops;
+  });
+
+  return 0;
+}
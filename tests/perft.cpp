@@ -1 +1,81 @@
-// keep empty for now, no second main
\ No newline at end of file
+#include "board.h"
+#include "movegen.h"
+#include "perfthash.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// File: perft.cpp
+// Purpose: Perft regression suite, run by CTest as blitz_perft_tests.
+// Notes:
+//  - Positions and counts are the standard ones from the Chess Programming
+//    Wiki perft results page.
+//  - Each position is checked plain, then threaded with a hash one ply
+//    shallower, so the threaded and cached paths are covered too.
+//  - An optional argument caps the depth for quick runs. A capped position
+//    reports its count without checking it.
+//  - Exit status is the number of failed checks.
+
+struct PerftCase {
+  const char* name;
+  const char* fen;
+  int depth;
+  unsigned long long nodes[8]; // expected count at depth 1..7, 0 if unused
+};
+
+static const PerftCase CASES[] = {
+  { "initial", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6,
+    { 20, 400, 8902, 197281, 4865609, 119060324 } },
+  { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5,
+    { 48, 2039, 97862, 4085603, 193690690 } },
+  { "position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 7,
+    { 14, 191, 2812, 43238, 674624, 11030083, 178633661 } },
+  { "position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5,
+    { 6, 264, 9467, 422333, 15833292 } },
+  { "position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5,
+    { 44, 1486, 62379, 2103487, 89941194 } },
+  { "position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5,
+    { 46, 2079, 89890, 3894594, 164075551 } },
+};
+
+// Run one perft, print the result line, return true if it matched
+static bool check(const PerftCase& c, int depth, int threads, PerftHash* cache, bool verify){
+  Board b;
+  if(!b.loadFEN(c.fen)){
+    std::printf("FAIL %-10s invalid FEN\n", c.name);
+    return false;
+  }
+  auto start = std::chrono::steady_clock::now();
+  unsigned long long nodes = perft(b, depth, threads, cache);
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const unsigned long long expected = c.nodes[depth - 1];
+  const bool ok = !verify || nodes == expected;
+  std::printf("%s %-10s depth %d threads %d%s nodes %12llu  %8.3f s  %6.1f Mnps",
+              ok ? "ok  " : "FAIL", c.name, depth, threads, cache ? " hash" : "     ",
+              nodes, sec, sec > 0 ? double(nodes) / sec / 1e6 : 0.0);
+  if(!ok) std::printf("  expected %llu", expected);
+  std::printf("\n");
+  return ok;
+}
+
+int main(int argc, char* argv[]){
+  const int maxDepth = argc > 1 ? std::atoi(argv[1]) : 99;
+  int failures = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  PerftHash cache;
+  cache.resize(32);
+  for(const PerftCase& c : CASES){
+    const int depth = c.depth < maxDepth ? c.depth : maxDepth;
+    const bool full = depth == c.depth;
+    if(!check(c, depth, 1, nullptr, full)) ++failures;
+    if(depth > 1){
+      cache.clear();
+      if(!check(c, depth - 1, 2, &cache, true)) ++failures;
+    }
+  }
+
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%d failure(s), %.3f s total\n", failures, sec);
+  return failures;
+}